@@ -0,0 +1,335 @@
+// funny-keyboard-bench <name> [args], offline measurements of the hot paths.
+// not part of the default build, configure with -DFUNNY_KEYBOARD_BENCH=ON
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <raylib.h>
+#include "click_synth.h"
+#include "trigger_engine.h"
+#include "typing_stats.h"
+#include "gif_decoder.h"
+#include "texture_codec.h"
+#include "effect_curves.h"
+#include "definitions.h"
+
+using bench_clock = std::chrono::steady_clock;
+
+static double seconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// 256 clicks kept ringing for 10 s of audio, rendered in device sized blocks
+static int bench_synth(int argc, char** argv)
+{
+    const int seconds = 10;
+    const int block = 480;
+
+    ClickSynth synth;
+    ClickSynthParams params;
+    params.body_decay_ms = 2000.0f;
+    params.noise_decay_ms = 50.0f;
+    int preset = synth.add_preset(params);
+
+    std::vector<float> samples((size_t)ClickSynth::SAMPLE_RATE * seconds);
+    int peak_voices = 0;
+
+    auto start = bench_clock::now();
+    for (size_t at = 0; at < samples.size(); at += block) {
+        // a fresh chord of every voice once a second
+        if (at % ClickSynth::SAMPLE_RATE == 0) {
+            for (int v = 0; v < ClickSynth::MAX_VOICES; v++) {
+                synth.trigger(preset, 1.0f / ClickSynth::MAX_VOICES);
+            }
+        }
+        synth.render(&samples[at], block);
+        peak_voices = std::max(peak_voices, synth.get_active_voices());
+    }
+    double elapsed = seconds_since(start);
+
+    std::cout << "synth: " << seconds << " s of audio, up to " << peak_voices << " voices, rendered in "
+              << elapsed * 1000.0 << " ms (" << elapsed / seconds * 100.0 << "% of a core)\n";
+
+    if (argc > 2) {
+        Wave wave = {
+            .frameCount = (unsigned int)samples.size(),
+            .sampleRate = ClickSynth::SAMPLE_RATE,
+            .sampleSize = 32,
+            .channels = 1,
+            .data = samples.data()
+        };
+        if (!ExportWave(wave, argv[2])) {
+            std::cout << "Failed to write " << argv[2] << "\n";
+            return 1;
+        }
+        std::cout << "wrote " << argv[2] << "\n";
+    }
+    return 0;
+}
+
+// random chords and letter sequences, then a stream of random presses through them
+static int bench_bindings(int argc, char** argv)
+{
+    const int bindings = argc > 2 ? std::max(std::atoi(argv[2]), 0) : 1000;
+    const int presses = 10000000;
+
+    std::mt19937 rng(1234);
+    auto letter = [&]() { return 'A' + (int)(rng() % 26); };
+
+    TriggerEngine engine;
+    for (int i = 0; i < bindings; i++) {
+        if (i % 2 == 0) {
+            engine.add_chord(1 + (int)(rng() % 15), letter(), i);
+        } else {
+            std::vector<int> keys(2 + rng() % 7);
+            for (int& vk : keys) vk = letter();
+            engine.add_sequence(keys, i);
+        }
+    }
+
+    auto start = bench_clock::now();
+    engine.compile();
+    double compile_time = seconds_since(start);
+
+    // one in eight presses under a held ctrl so chords fire as well
+    std::vector<int> keys(presses);
+    for (int& vk : keys) vk = rng() % 8 == 0 ? -letter() : letter();
+
+    size_t fired = 0;
+    start = bench_clock::now();
+    for (int vk : keys) {
+        if (vk < 0) {
+            engine.key_down(0xA2);
+            fired += engine.key_down(-vk).size();
+            engine.key_up(-vk);
+            engine.key_up(0xA2);
+        } else {
+            fired += engine.key_down(vk).size();
+            engine.key_up(vk);
+        }
+    }
+    double elapsed = seconds_since(start);
+
+    std::cout << "bindings: " << bindings << " bindings, " << engine.get_state_count() << " dfa states, compiled in "
+              << compile_time * 1000.0 << " ms, " << elapsed / presses * 1e9 << " ns per press (" << fired << " fired)\n";
+    return 0;
+}
+
+// a stats file fed ten million presses typed at 40-400 ms apart
+static int bench_stats(int argc, char** argv)
+{
+    const char* path = argc > 2 ? argv[2] : "bench-stats.bin";
+    const int presses = 10000000;
+
+    TypingStats stats;
+    bool mapped = stats.open(path);
+
+    std::mt19937 rng(1234);
+    std::vector<std::pair<int, uint32_t>> events(presses);
+    uint32_t time_ms = 0;
+    for (auto& [vk, time] : events) {
+        vk = rng() % 6 == 0 ? 0x20 : 'A' + (int)(rng() % 26);
+        time_ms += 40 + rng() % 360;
+        time = time_ms;
+    }
+
+    auto start = bench_clock::now();
+    for (const auto& [vk, time] : events) {
+        stats.record_press(vk, time);
+    }
+    double elapsed = seconds_since(start);
+
+    std::cout << "stats: " << presses << " presses into " << (mapped ? path : "memory (file not mapped)") << ", "
+              << elapsed / presses * 1e9 << " ns per press, average " << stats.get_average_wpm() << " wpm\n";
+    return 0;
+}
+
+static PROCESS_MEMORY_COUNTERS memory_counters()
+{
+    PROCESS_MEMORY_COUNTERS counters = {};
+    counters.cb = sizeof(counters);
+    K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, counters.cb);
+    return counters;
+}
+
+// the staging half of a gif load, up to the frames handed to upload_staged,
+// which needs a gl context. the peak working set only ever grows, so each
+// mode gets its own run
+static int bench_gif(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cout << "gif needs a file and a mode, decoder or raylib\n";
+        return 1;
+    }
+    const char* path = argv[2];
+    bool decoder_mode = std::strcmp(argv[3], "decoder") == 0;
+    if (!decoder_mode && std::strcmp(argv[3], "raylib") != 0) {
+        std::cout << "unknown gif mode " << argv[3] << "\n";
+        return 1;
+    }
+    const int size = argc > 4 ? std::clamp(std::atoi(argv[4]), 4, 1024) : 64;
+
+    size_t baseline = memory_counters().WorkingSetSize;
+    std::vector<Image> staged;
+    int width = 0, height = 0;
+
+    auto start = bench_clock::now();
+    if (decoder_mode) {
+        // AnimatedTexture::load_gif
+        int file_size = 0;
+        unsigned char* file_data = LoadFileData(path, &file_size);
+        GifDecoder decoder;
+        if (file_data && decoder.open(file_data, (size_t)file_size)) {
+            width = decoder.get_width();
+            height = decoder.get_height();
+            float delay = 0.0f;
+            while (decoder.next_frame(delay)) {
+                Image img = GenImageColor(size, size, (Color){0, 0, 0, 0});
+                texture_codec::downscale_box(decoder.get_canvas(), width, height, (Color*)img.data, size, size);
+                staged.push_back(img);
+            }
+        }
+        UnloadFileData(file_data);
+    } else {
+        // the LoadImageAnim path it replaced, every frame decoded up front
+        int frame_count = 0;
+        Image anim = LoadImageAnim(path, &frame_count);
+        if (anim.data && frame_count > 0) {
+            width = anim.width;
+            height = anim.height / frame_count;
+            for (int i = 0; i < frame_count; i++) {
+                Image img = ImageFromImage(anim, (Rectangle){0, (float)(i * height), (float)width, (float)height});
+                ImageResize(&img, size, size);
+                ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+                staged.push_back(img);
+            }
+        }
+        UnloadImage(anim);
+    }
+    double elapsed = seconds_since(start);
+    size_t peak = memory_counters().PeakWorkingSetSize;
+
+    if (staged.empty()) {
+        std::cout << "Failed to load " << path << "\n";
+        return 1;
+    }
+
+    std::cout << "gif " << argv[3] << ": " << staged.size() << " frames of " << width << "x" << height << " staged at "
+              << size << "x" << size << " in " << elapsed * 1000.0 << " ms, peak working set "
+              << (peak > baseline ? peak - baseline : 0) / 1024 << " KiB above the "
+              << baseline / 1024 << " KiB before loading\n";
+
+    for (Image& img : staged) {
+        UnloadImage(img);
+    }
+    return 0;
+}
+
+// the simulation step's animation half, the old hardcoded fade and growth
+// against the default curve (the fade_and_grow path) and an eased one (the
+// table) over the same staggered effects
+static int bench_curves(int argc, char** argv)
+{
+    const int count = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 256;
+    const int steps = 20000;
+    const auto step = std::chrono::microseconds(16667);
+
+    struct Effect {
+        bench_clock::time_point start_time;
+        CurvePose pose;
+    };
+
+    std::mt19937 rng(1234);
+    auto now = bench_clock::now();
+    std::vector<Effect> staggered(count);
+    for (Effect& effect : staggered) {
+        effect.start_time = now - std::chrono::microseconds(rng() % 1000000);
+    }
+
+    size_t restarts = 0;
+    std::vector<Effect> effects = staggered;
+    auto start = bench_clock::now();
+    for (int s = 0; s < steps; s++) {
+        auto time = now + step * s;
+        for (Effect& effect : effects) {
+            float elapsed = std::chrono::duration<float>(time - effect.start_time).count();
+            effect.pose.alpha = 1.0f - elapsed;
+            effect.pose.scale = 1.0f + elapsed * 0.5f;
+            if (effect.pose.alpha <= 0.0f) {
+                effect.start_time = time;
+                restarts++;
+            }
+        }
+    }
+    double linear = seconds_since(start);
+
+    auto run_curve = [&](const EffectCurve& curve) {
+        std::vector<Effect> curved = staggered;
+        for (Effect& effect : curved) {
+            curve.start(effect.pose);
+        }
+
+        auto start = bench_clock::now();
+        for (int s = 0; s < steps; s++) {
+            auto time = now + step * s;
+            for (Effect& effect : curved) {
+                float elapsed = std::chrono::duration<float>(time - effect.start_time).count();
+                if (!curve.evaluate(elapsed, effect.pose)) {
+                    effect.start_time = time;
+                    restarts++;
+                }
+            }
+        }
+        return seconds_since(start);
+    };
+
+    CurveSpec eased_spec = CurveSpec::standard();
+    eased_spec.channels[CURVE_ALPHA].back().ease = Easing::EASE_IN;
+    eased_spec.channels[CURVE_SCALE].back().ease = Easing::BACK_OUT;
+
+    double standard = run_curve(EffectCurve());
+    double eased = run_curve(EffectCurve(eased_spec));
+
+    double evaluations = (double)count * steps;
+    std::cout << "curves: " << count << " effects, per effect per step " << linear / evaluations * 1e9
+              << " ns linear, " << standard / evaluations * 1e9 << " ns default curve, " << eased / evaluations * 1e9
+              << " ns eased curve (" << restarts << " restarts)\n";
+    return 0;
+}
+
+struct Bench {
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+};
+
+static const Bench BENCHES[] = {
+    {"synth", "synth [out.wav]                   render 256 overlapping clicks offline", bench_synth},
+    {"bindings", "bindings [count]                  random chords and sequences, cost per key press", bench_bindings},
+    {"stats", "stats [file]                      record_press cost, adds to file (bench-stats.bin)", bench_stats},
+    {"gif", "gif <file> decoder|raylib [size]  staging time and peak memory of one gif load", bench_gif},
+    {"curves", "curves [count]                    curve evaluation against the old linear ramps", bench_curves},
+};
+
+int main(int argc, char** argv)
+{
+    SetTraceLogLevel(LOG_WARNING);
+
+    for (const Bench& bench : BENCHES) {
+        if (argc > 1 && std::strcmp(argv[1], bench.name) == 0) {
+            return bench.run(argc, argv);
+        }
+    }
+
+    std::cout << "usage: funny-keyboard-bench <bench> [args]\n";
+    for (const Bench& bench : BENCHES) {
+        std::cout << "  " << bench.usage << "\n";
+    }
+    return 1;
+}
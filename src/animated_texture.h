@@ -2,9 +2,26 @@
 
 #include <vector>
 #include <string>
+#include <chrono>
 #include <raylib.h>
 #include <webp/decode.h>
 #include <webp/demux.h>
+#include "texture_codec.h"
+#include "gif_decoder.h"
+
+struct TextureOptions {
+    int size = 64;
+    TextureStorage storage = TextureStorage::RGBA;
+};
+
+// what loading one asset cost, for the load log
+struct TextureReport {
+    TextureStorage storage = TextureStorage::RGBA;
+    int frame_count = 0;
+    size_t raw_bytes = 0;
+    size_t stored_bytes = 0;
+    float upload_ms = 0.0f;
+};
 
 class AnimatedTexture {
 public:
@@ -17,11 +34,15 @@ public:
         : filename(std::move(other.filename))
         , frames(std::move(other.frames))
         , frame_delays(std::move(other.frame_delays))
+        , palette(other.palette)
+        , options(other.options)
+        , report(other.report)
         , current_frame(other.current_frame)
         , frame_time(other.frame_time)
         , is_animated(other.is_animated)
     {
         other.frames.clear();
+        other.palette = {0};
     }
     
     AnimatedTexture& operator=(AnimatedTexture&& other) noexcept {
@@ -30,10 +51,14 @@ public:
             filename = std::move(other.filename);
             frames = std::move(other.frames);
             frame_delays = std::move(other.frame_delays);
+            palette = other.palette;
+            options = other.options;
+            report = other.report;
             current_frame = other.current_frame;
             frame_time = other.frame_time;
             is_animated = other.is_animated;
             other.frames.clear();
+            other.palette = {0};
         }
         return *this;
     }
@@ -42,8 +67,14 @@ public:
         unload();
     }
     
-    bool load_from_file(const std::string& filepath) {
+    bool load_from_file(const std::string& filepath, const TextureOptions& texture_options = {}) {
         filename = filepath;
+        options = texture_options;
+        
+        // block compression works on 4x4 blocks
+        if (options.size < 4) options.size = 4;
+        if (options.size > 1024) options.size = 1024;
+        options.size = (options.size + 3) & ~3;
         
         std::string ext = get_file_extension(filepath);
         
@@ -87,6 +118,15 @@ public:
         return frames.empty() ? 0 : frames[0].height;
     }
     
+    // 256x1 lookup for palettized storage, id 0 otherwise
+    const Texture2D& get_palette() const {
+        return palette;
+    }
+    
+    const TextureReport& get_report() const {
+        return report;
+    }
+    
 private:
     void unload() {
         for (auto& tex : frames) {
@@ -96,46 +136,163 @@ private:
         }
         frames.clear();
         frame_delays.clear();
+        
+        if (palette.id > 0) {
+            UnloadTexture(palette);
+        }
+        palette = {0};
+        
+        for (auto& img : staged) {
+            UnloadImage(img);
+        }
+        staged.clear();
     }
     
-    bool load_gif(const std::string& filepath) {
-        int frame_count = 0;
-        Image anim = LoadImageAnim(filepath.c_str(), &frame_count);
-        
-        if (anim.data == nullptr || frame_count <= 0) {
-            return false;
+    // every loader resizes its frames into staged, then this encodes them
+    // for the configured storage and uploads
+    void stage(Image& img, float delay) {
+        ImageResize(&img, options.size, options.size);
+        ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        staged.push_back(img);
+        frame_delays.push_back(delay);
+    }
+    
+    // stages a frame the loader still owns, shrinking straight from it when it
+    // is at least the target size so the full size frame is never copied
+    void stage_pixels(const Color* pixels, int w, int h, float delay) {
+        if (w >= options.size && h >= options.size) {
+            Image img = GenImageColor(options.size, options.size, (Color){0, 0, 0, 0});
+            texture_codec::downscale_box(pixels, w, h, (Color*)img.data, options.size, options.size);
+            staged.push_back(img);
+            frame_delays.push_back(delay);
+        } else {
+            Image view = {
+                .data = (void*)pixels,
+                .width = w,
+                .height = h,
+                .mipmaps = 1,
+                .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+            };
+            Image img = ImageCopy(view);
+            stage(img, delay);
         }
-
-        int frame_width = anim.width;
-        int frame_height = anim.height / frame_count;
+    }
+    
+    bool upload_staged() {
+        auto start = std::chrono::steady_clock::now();
         
-
-        std::vector<Image> frame_images;
-        for (int i = 0; i < frame_count; i++) {
-            Rectangle source_rect = {0, (float)(i * frame_height), (float)frame_width, (float)frame_height};
-            Image frame_img = ImageFromImage(anim, source_rect);
-            frame_images.push_back(frame_img);
+        int w = options.size, h = options.size;
+        report.storage = options.storage;
+        report.frame_count = (int)staged.size();
+        report.raw_bytes = (size_t)w * h * 4 * staged.size();
+        report.stored_bytes = 0;
+        
+        std::vector<Color> palette_entries;
+        if (options.storage == TextureStorage::PALETTE) {
+            std::vector<const Color*> pixels;
+            for (auto& img : staged) {
+                pixels.push_back((const Color*)img.data);
+            }
+            palette_entries = texture_codec::build_palette(pixels, w * h);
+            
+            Image palette_img = GenImageColor(256, 1, (Color){0, 0, 0, 0});
+            std::copy(palette_entries.begin(), palette_entries.end(), (Color*)palette_img.data);
+            palette = LoadTextureFromImage(palette_img);
+            UnloadImage(palette_img);
+            report.stored_bytes += 256 * 4;
         }
         
-        UnloadImage(anim);
+        bool ok = options.storage != TextureStorage::PALETTE || palette.id > 0;
         
-        for (auto& frame_img : frame_images) {
-            ImageResize(&frame_img, 64, 64);
+        // decided on the first frame, a driver without s3tc gets the whole
+        // asset uncompressed rather than a mix of both
+        Texture2D first_dxt = {0};
+        if (options.storage == TextureStorage::DXT && !staged.empty()) {
+            first_dxt = upload_dxt(staged[0]);
+            if (first_dxt.id == 0) {
+                options.storage = TextureStorage::RGBA;
+                report.storage = TextureStorage::RGBA;
+            }
+        }
+        
+        for (size_t i = 0; i < staged.size(); i++) {
+            Image& img = staged[i];
+            Texture2D tex = {0};
             
-            Texture2D frame_tex = LoadTextureFromImage(frame_img);
-            UnloadImage(frame_img);
+            if (ok && options.storage == TextureStorage::PALETTE) {
+                Image index_img = {
+                    .data = texture_codec::map_to_palette((const Color*)img.data, w * h, palette_entries),
+                    .width = w,
+                    .height = h,
+                    .mipmaps = 1,
+                    .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE
+                };
+                tex = LoadTextureFromImage(index_img);
+                UnloadImage(index_img);
+            } else if (ok && options.storage == TextureStorage::DXT) {
+                tex = i == 0 ? first_dxt : upload_dxt(img);
+            } else if (ok) {
+                tex = LoadTextureFromImage(img);
+            }
             
-            if (frame_tex.id == 0) {
-                for (auto& tex : frames) {
-                    if (tex.id > 0) UnloadTexture(tex);
-                }
-                frames.clear();
-                frame_delays.clear();
-                return false;
+            if (tex.id == 0) {
+                ok = false;
+                break;
             }
             
-            frames.push_back(frame_tex);
-            frame_delays.push_back(0.1f);
+            report.stored_bytes += GetPixelDataSize(tex.width, tex.height, tex.format);
+            frames.push_back(tex);
+        }
+        
+        for (auto& img : staged) {
+            UnloadImage(img);
+        }
+        staged.clear();
+        
+        if (!ok) {
+            unload();
+            return false;
+        }
+        
+        report.upload_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return !frames.empty();
+    }
+    
+    Texture2D upload_dxt(const Image& img) {
+        Image dxt_img = {
+            .data = texture_codec::encode_dxt5((const Color*)img.data, img.width, img.height),
+            .width = img.width,
+            .height = img.height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_COMPRESSED_DXT5_RGBA
+        };
+        Texture2D tex = LoadTextureFromImage(dxt_img);
+        UnloadImage(dxt_img);
+        return tex;
+    }
+    
+    // frames are decoded one at a time into the decoder's canvas and shrunk
+    // from there, only the target size copies are kept until upload
+    bool load_gif(const std::string& filepath) {
+        int file_size = 0;
+        unsigned char* file_data = LoadFileData(filepath.c_str(), &file_size);
+        if (!file_data) {
+            return false;
+        }
+        
+        GifDecoder decoder;
+        if (decoder.open(file_data, (size_t)file_size)) {
+            float delay = 0.0f;
+            while (decoder.next_frame(delay)) {
+                stage_pixels(decoder.get_canvas(), decoder.get_width(), decoder.get_height(), delay);
+            }
+        }
+        UnloadFileData(file_data);
+        
+        // a truncated file still shows the frames before the damage
+        int frame_count = (int)staged.size();
+        if (frame_count == 0 || !upload_staged()) {
+            return false;
         }
         
         is_animated = (frame_count > 1);
@@ -182,15 +339,8 @@ private:
                         Image img_copy = ImageCopy(img);
                         WebPFree(rgba);
                         
-                        ImageResize(&img_copy, 64, 64);
-                        
-                        Texture2D tex = LoadTextureFromImage(img_copy);
-                        UnloadImage(img_copy);
-                        
-                        frames.push_back(tex);
-                        
                         float delay_ms = iter.duration;
-                        frame_delays.push_back(delay_ms / 1000.0f);
+                        stage(img_copy, delay_ms / 1000.0f);
                     }
                 } while (WebPDemuxNextFrame(&iter));
                 
@@ -215,13 +365,7 @@ private:
                 Image img_copy = ImageCopy(img);
                 WebPFree(rgba);
                 
-                ImageResize(&img_copy, 64, 64);
-                
-                Texture2D tex = LoadTextureFromImage(img_copy);
-                UnloadImage(img_copy);
-                
-                frames.push_back(tex);
-                frame_delays.push_back(0.0f);
+                stage(img_copy, 0.0f);
             }
             
             is_animated = false;
@@ -230,7 +374,7 @@ private:
         WebPDemuxDelete(demux);
         UnloadFileData(file_data);
         
-        return !frames.empty();
+        return upload_staged();
     }
     
     bool load_static(const std::string& filepath) {
@@ -240,20 +384,10 @@ private:
             return false;
         }
         
-        ImageResize(&img, 64, 64);
-        
-        Texture2D tex = LoadTextureFromImage(img);
-        UnloadImage(img);
-        
-        if (tex.id == 0) {
-            return false;
-        }
-        
-        frames.push_back(tex);
-        frame_delays.push_back(0.0f);
+        stage(img, 0.0f);
         is_animated = false;
         
-        return true;
+        return upload_staged();
     }
     
     std::string get_file_extension(const std::string& filepath) {
@@ -272,6 +406,10 @@ private:
     std::string filename;
     std::vector<Texture2D> frames;
     std::vector<float> frame_delays;
+    std::vector<Image> staged;
+    Texture2D palette = {0};
+    TextureOptions options;
+    TextureReport report;
     size_t current_frame;
     float frame_time;
     bool is_animated;
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <raylib.h>
+
+enum class CaptureFormat {
+    RAW,    // rgba frames back to back, no header
+    Y4M,    // yuv 4:4:4 with alpha (C444alpha), ffmpeg reads it as yuva444p
+    PNG     // one file per frame
+};
+
+// a readback of part of the frame, rows bottom up like gl returns them
+struct CaptureFrame {
+    int x = 0, y = 0;       // top left on the frame
+    int width = 0, height = 0;
+    int repeats_before = 0; // frames dropped just before this one, written as copies of the previous
+    std::vector<unsigned char> pixels;
+};
+
+// owns the full frame and the output, patches every readback into it on its
+// own thread and writes the result. frames come from a fixed pool so a slow
+// disk drops frames instead of growing memory. no gl, so it can run without a window
+class CaptureEncoder {
+public:
+    CaptureEncoder() = default;
+
+    CaptureEncoder(const CaptureEncoder&) = delete;
+    CaptureEncoder& operator=(const CaptureEncoder&) = delete;
+
+    ~CaptureEncoder() {
+        stop();
+    }
+
+    // path gets the format's extension, or _000001.png and up for png
+    bool start(const std::string& path, CaptureFormat capture_format, int frame_width, int frame_height, int fps, int queue_size) {
+        stop();
+
+        format = capture_format;
+        base_path = path;
+        width = frame_width;
+        height = frame_height;
+        written = 0;
+
+        if (format != CaptureFormat::PNG) {
+            output_path = path + (format == CaptureFormat::Y4M ? ".y4m" : ".rgba");
+            file = std::fopen(output_path.c_str(), "wb");
+            if (!file) return false;
+            if (format == CaptureFormat::Y4M) {
+                std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444alpha\n", width, height, fps);
+            }
+        } else {
+            output_path = path + "_%06d.png";
+        }
+
+        canvas.assign((size_t)width * height * 4, 0);
+        planes.clear();
+
+        free_frames.clear();
+        for (int i = 0; i < std::max(queue_size, 1); i++) {
+            free_frames.push_back(new CaptureFrame());
+        }
+
+        running = true;
+        worker = std::thread(&CaptureEncoder::run, this);
+        return true;
+    }
+
+    // writes everything still queued, then closes the output
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            running = false;
+        }
+        wake.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        for (CaptureFrame* frame : free_frames) delete frame;
+        for (CaptureFrame* frame : queued) delete frame;
+        free_frames.clear();
+        queued.clear();
+    }
+
+    bool is_running() const {
+        return worker.joinable();
+    }
+
+    // producer side, null when every frame is still queued. with wait it
+    // blocks until the encoder hands one back instead
+    CaptureFrame* acquire(bool wait = false) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (wait) {
+            freed.wait(lock, [this] { return !free_frames.empty(); });
+        }
+        if (free_frames.empty()) return nullptr;
+        CaptureFrame* frame = free_frames.back();
+        free_frames.pop_back();
+        return frame;
+    }
+
+    // a frame with width or height 0 repeats the previous one
+    void submit(CaptureFrame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            queued.push_back(frame);
+        }
+        wake.notify_one();
+    }
+
+    uint64_t get_written() const {
+        return written.load(std::memory_order_relaxed);
+    }
+
+    const std::string& get_output_path() const {
+        return output_path;
+    }
+
+private:
+    void run() {
+        std::vector<CaptureFrame*> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                wake.wait(lock, [this] { return !running || !queued.empty(); });
+                if (queued.empty()) return;
+                batch.swap(queued);
+            }
+
+            for (CaptureFrame* frame : batch) {
+                // the stream has a fixed rate, dropped frames still take their time
+                for (int i = 0; i < frame->repeats_before; i++) {
+                    write_frame();
+                }
+                patch(*frame);
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex);
+                    free_frames.push_back(frame);
+                }
+                freed.notify_one();
+                write_frame();
+            }
+            batch.clear();
+        }
+    }
+
+    void patch(const CaptureFrame& frame) {
+        size_t row_bytes = (size_t)frame.width * 4;
+        for (int row = 0; row < frame.height; row++) {
+            // gl rows are bottom up
+            const unsigned char* src = &frame.pixels[(size_t)(frame.height - 1 - row) * row_bytes];
+            std::memcpy(&canvas[((size_t)(frame.y + row) * width + frame.x) * 4], src, row_bytes);
+        }
+    }
+
+    void write_frame() {
+        uint64_t index = written.load(std::memory_order_relaxed) + 1;
+
+        if (format == CaptureFormat::RAW) {
+            std::fwrite(canvas.data(), 1, canvas.size(), file);
+        } else if (format == CaptureFormat::Y4M) {
+            write_y4m();
+        } else {
+            char name[32];
+            std::snprintf(name, sizeof(name), "_%06llu.png", (unsigned long long)index);
+            Image view = {
+                .data = canvas.data(),
+                .width = width,
+                .height = height,
+                .mipmaps = 1,
+                .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+            };
+            ExportImage(view, (base_path + name).c_str());
+        }
+
+        written.store(index, std::memory_order_relaxed);
+    }
+
+    // bt.601 studio range, what y4m readers assume without a color range tag
+    void write_y4m() {
+        size_t pixels = (size_t)width * height;
+        planes.resize(pixels * 4);
+        unsigned char* y_plane = planes.data();
+        unsigned char* u_plane = y_plane + pixels;
+        unsigned char* v_plane = u_plane + pixels;
+        unsigned char* a_plane = v_plane + pixels;
+
+        for (size_t i = 0; i < pixels; i++) {
+            int r = canvas[i * 4], g = canvas[i * 4 + 1], b = canvas[i * 4 + 2];
+            y_plane[i] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            u_plane[i] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            v_plane[i] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            a_plane[i] = canvas[i * 4 + 3];
+        }
+
+        std::fputs("FRAME\n", file);
+        std::fwrite(planes.data(), 1, planes.size(), file);
+    }
+
+    CaptureFormat format = CaptureFormat::Y4M;
+    std::string base_path;
+    std::string output_path;
+    std::FILE* file = nullptr;
+    int width = 0;
+    int height = 0;
+
+    std::vector<unsigned char> canvas;  // encoder thread only
+    std::vector<unsigned char> planes;
+
+    std::thread worker;
+    std::mutex queue_mutex;
+    std::condition_variable wake;
+    std::condition_variable freed;
+    std::vector<CaptureFrame*> free_frames;
+    std::vector<CaptureFrame*> queued;
+    bool running = false;
+    std::atomic<uint64_t> written{0};
+};
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <raylib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLICK_SYNTH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// a click is a short noise burst (the switch) on top of a decaying
+// resonance (the keycap/case body)
+struct ClickSynthParams {
+    float pitch = 1800.0f;          // body resonance, Hz
+    float body_decay_ms = 25.0f;    // time to fall by 60 dB
+    float noise = 0.6f;             // noise burst level relative to the body
+    float noise_decay_ms = 4.0f;
+    float gain = 0.8f;
+    float randomize = 0.1f;         // per press spread of pitch, decay and gain, 0..1
+};
+
+// voices are stored as structure of arrays and stepped 4 at a time, every
+// voice costs a handful of multiplies per sample no matter how many overlap
+class ClickSynth {
+public:
+    static constexpr int MAX_VOICES = 256;
+    static constexpr int SAMPLE_RATE = 48000;
+
+    ClickSynth() {
+        clear_voices();
+    }
+
+    ClickSynth(const ClickSynth&) = delete;
+    ClickSynth& operator=(const ClickSynth&) = delete;
+
+    ~ClickSynth() {
+        unload();
+    }
+
+    int add_preset(const ClickSynthParams& params) {
+        presets.push_back(params);
+        return (int)presets.size() - 1;
+    }
+
+    bool has_presets() const {
+        return !presets.empty();
+    }
+
+    // needs the audio device, raylib pulls samples from its mixer thread
+    bool start() {
+        if (stream.buffer) return true;
+
+        stream = LoadAudioStream(SAMPLE_RATE, 32, 1);
+        if (!IsAudioStreamValid(stream)) {
+            stream = {};
+            return false;
+        }
+
+        // raylib callbacks carry no user pointer
+        active_synth = this;
+        SetAudioStreamCallback(stream, audio_callback);
+        PlayAudioStream(stream);
+        return true;
+    }
+
+    void unload() {
+        if (stream.buffer) {
+            StopAudioStream(stream);
+            UnloadAudioStream(stream);
+            stream = {};
+        }
+        if (active_synth == this) {
+            active_synth = nullptr;
+        }
+    }
+
+    // any thread, the voice starts on the next mixer callback
+    void trigger(int preset, float volume) {
+        if (preset < 0 || preset >= (int)presets.size()) return;
+
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (pending.size() < MAX_VOICES) {
+            pending.push_back({preset, volume});
+        }
+    }
+
+    // mono float samples, also usable offline without a device
+    void render(float* out, int frames) {
+#ifdef CLICK_SYNTH_SSE2
+        // a short burst under a long ring decays into denormals well before
+        // the voice retires, and those cost ten times as much, so flush them
+        unsigned int csr = _mm_getcsr();
+        _mm_setcsr(csr | FLUSH_DENORMALS);
+#endif
+        start_pending();
+
+        int groups = (active_end + 3) / 4;
+        for (int i = 0; i < frames; i++) {
+            out[i] = groups > 0 ? step(groups) : 0.0f;
+        }
+
+        retire_voices();
+        voices_playing.store(active_count, std::memory_order_relaxed);
+#ifdef CLICK_SYNTH_SSE2
+        _mm_setcsr(csr);
+#endif
+    }
+
+    // any thread, as of the last audio callback
+    int get_active_voices() const {
+        return voices_playing.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Trigger {
+        int preset;
+        float volume;
+    };
+
+    // below this both envelopes are inaudible and the voice is recycled
+    static constexpr float SILENCE = 1.0e-4f;
+
+#ifdef CLICK_SYNTH_SSE2
+    static constexpr unsigned int FLUSH_DENORMALS = 0x8040;    // MXCSR flush to zero | denormals are zero
+#endif
+
+    static void audio_callback(void* buffer, unsigned int frames) {
+        if (active_synth) {
+            active_synth->render((float*)buffer, (int)frames);
+        } else {
+            std::memset(buffer, 0, frames * sizeof(float));
+        }
+    }
+
+    void clear_voices() {
+        for (int v = 0; v < MAX_VOICES; v++) {
+            re[v] = im[v] = rot_c[v] = rot_s[v] = 0.0f;
+            noise_amp[v] = noise_mul[v] = noise_prev[v] = 0.0f;
+            rng[v] = 0x9E3779B9u * (uint32_t)(v + 1);
+        }
+        active_end = active_count = 0;
+    }
+
+    // the mixer thread must never wait on the hook, presses that lose the
+    // race are picked up by the next callback
+    void start_pending() {
+        std::unique_lock<std::mutex> lock(pending_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || pending.empty()) return;
+
+        for (const Trigger& trigger : pending) {
+            start_voice(presets[trigger.preset], trigger.volume);
+        }
+        pending.clear();
+    }
+
+    void start_voice(const ClickSynthParams& p, float volume) {
+        int v = 0;
+        while (v < MAX_VOICES && !is_silent(v)) v++;
+        if (v == MAX_VOICES) {
+            // steal the quietest
+            v = 0;
+            for (int i = 1; i < MAX_VOICES; i++) {
+                if (std::fabs(re[i]) + std::fabs(im[i]) + noise_amp[i] < std::fabs(re[v]) + std::fabs(im[v]) + noise_amp[v]) v = i;
+            }
+        } else {
+            active_count++;
+        }
+
+        float pitch = p.pitch * (1.0f + spread(p.randomize * 0.2f));
+        float body_decay = std::fmax(p.body_decay_ms * (1.0f + spread(p.randomize * 0.5f)), 0.1f);
+        float noise_decay = std::fmax(p.noise_decay_ms * (1.0f + spread(p.randomize * 0.5f)), 0.1f);
+        float gain = p.gain * volume * (1.0f + spread(p.randomize * 0.3f));
+
+        // a damped rotator is a resonant filter's impulse response, r sets the decay
+        float w = 6.2831853f * std::fmin(pitch, SAMPLE_RATE * 0.45f) / SAMPLE_RATE;
+        float r = std::pow(1.0e-3f, 1000.0f / (body_decay * SAMPLE_RATE));
+        rot_c[v] = r * std::cos(w);
+        rot_s[v] = r * std::sin(w);
+        re[v] = gain;
+        im[v] = 0.0f;
+
+        noise_amp[v] = gain * p.noise;
+        noise_mul[v] = std::pow(1.0e-3f, 1000.0f / (noise_decay * SAMPLE_RATE));
+        noise_prev[v] = 0.0f;
+
+        if (v + 1 > active_end) active_end = v + 1;
+    }
+
+    float spread(float amount) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return amount * ((float)(seed & 0xFFFF) / 32767.5f - 1.0f);
+    }
+
+    bool is_silent(int v) const {
+        return std::fabs(re[v]) + std::fabs(im[v]) < SILENCE && noise_amp[v] < SILENCE;
+    }
+
+    void retire_voices() {
+        active_count = 0;
+        int end = 0;
+        for (int v = 0; v < active_end; v++) {
+            if (is_silent(v)) {
+                re[v] = im[v] = noise_amp[v] = 0.0f;
+            } else {
+                active_count++;
+                end = v + 1;
+            }
+        }
+        active_end = end;
+    }
+
+    // one output sample from the first groups*4 voices
+    float step(int groups) {
+#ifdef CLICK_SYNTH_SSE2
+        const __m128 to_float = _mm_set1_ps(1.0f / 2147483648.0f);
+        __m128 sum = _mm_setzero_ps();
+
+        for (int g = 0; g < groups * 4; g += 4) {
+            __m128 a = _mm_load_ps(re + g);
+            __m128 b = _mm_load_ps(im + g);
+            __m128 c = _mm_load_ps(rot_c + g);
+            __m128 s = _mm_load_ps(rot_s + g);
+            __m128 next_re = _mm_sub_ps(_mm_mul_ps(a, c), _mm_mul_ps(b, s));
+            __m128 next_im = _mm_add_ps(_mm_mul_ps(a, s), _mm_mul_ps(b, c));
+            _mm_store_ps(re + g, next_re);
+            _mm_store_ps(im + g, next_im);
+
+            // xorshift32 per voice, differenced so the burst sits in the highs
+            __m128i x = _mm_load_si128((const __m128i*)(rng + g));
+            x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+            x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+            x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+            _mm_store_si128((__m128i*)(rng + g), x);
+
+            __m128 white = _mm_mul_ps(_mm_cvtepi32_ps(x), to_float);
+            __m128 prev = _mm_load_ps(noise_prev + g);
+            _mm_store_ps(noise_prev + g, white);
+
+            __m128 amp = _mm_load_ps(noise_amp + g);
+            _mm_store_ps(noise_amp + g, _mm_mul_ps(amp, _mm_load_ps(noise_mul + g)));
+
+            sum = _mm_add_ps(sum, _mm_add_ps(next_im, _mm_mul_ps(amp, _mm_sub_ps(white, prev))));
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, sum);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+        float sum = 0.0f;
+        for (int v = 0; v < groups * 4; v++) {
+            float next_re = re[v] * rot_c[v] - im[v] * rot_s[v];
+            float next_im = re[v] * rot_s[v] + im[v] * rot_c[v];
+            re[v] = next_re;
+            im[v] = next_im;
+
+            uint32_t x = rng[v];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            rng[v] = x;
+
+            float white = (float)(int32_t)x / 2147483648.0f;
+            sum += next_im + noise_amp[v] * (white - noise_prev[v]);
+            noise_prev[v] = white;
+            noise_amp[v] *= noise_mul[v];
+        }
+        return sum;
+#endif
+    }
+
+    alignas(16) float re[MAX_VOICES];
+    alignas(16) float im[MAX_VOICES];
+    alignas(16) float rot_c[MAX_VOICES];
+    alignas(16) float rot_s[MAX_VOICES];
+    alignas(16) float noise_amp[MAX_VOICES];
+    alignas(16) float noise_mul[MAX_VOICES];
+    alignas(16) float noise_prev[MAX_VOICES];
+    alignas(16) uint32_t rng[MAX_VOICES];
+    int active_end = 0;     // voices past this are silent
+    int active_count = 0;
+    std::atomic<int> voices_playing{0};
+    uint32_t seed = 0x2545F491u;
+
+    std::vector<ClickSynthParams> presets;
+    std::mutex pending_mutex;
+    std::vector<Trigger> pending;
+
+    AudioStream stream = {};
+    static inline ClickSynth* active_synth = nullptr;
+};
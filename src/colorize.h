@@ -0,0 +1,145 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <raylib.h>
+#include <rlgl.h>
+
+struct ColorizeConfig {
+    Color color = {255, 255, 255, 255};
+    Color gradient = {255, 255, 255, 255};  // bottom of the sprite when use_gradient is set
+    bool use_gradient = false;
+    float hue_cycle = 0.0f;                 // hue turns per second
+    std::map<std::string, Color> per_key;
+};
+
+// glow + tint in one draw: the old additive pass followed by the alpha pass
+// leaves c*(a1 + a0*(1 - a1)) + dst*(1 - a1), which is premultiplied output
+// with a1 as coverage
+static const char* COLORIZE_FS = R"(
+#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec3 u_gradient;
+uniform float u_gradient_mix;
+uniform float u_hue_shift;
+uniform float u_glow;
+uniform sampler2D u_palette;
+uniform float u_paletted;
+out vec4 finalColor;
+
+vec3 hue_rotate(vec3 c, float angle) {
+    const vec3 k = vec3(0.57735026);
+    float ca = cos(angle);
+    return c * ca + cross(k, c) * sin(angle) + k * dot(k, c) * (1.0 - ca);
+}
+
+void main() {
+    vec4 texel = texture(texture0, fragTexCoord);
+    if (u_paletted > 0.5) {
+        // 8-bit index in the red channel, 256x1 palette
+        texel = texture(u_palette, vec2((texel.r * 255.0 + 0.5) / 256.0, 0.5));
+    }
+    texel *= colDiffuse;
+    vec3 tint = mix(fragColor.rgb, u_gradient, u_gradient_mix * fragTexCoord.y);
+    tint = clamp(hue_rotate(tint, u_hue_shift), 0.0, 1.0);
+    vec3 color = texel.rgb * tint;
+    float a1 = texel.a * fragColor.a;
+    float a0 = a1 * u_glow;
+    finalColor = vec4(color * (a1 + a0 * (1.0 - a1)), a1);
+}
+)";
+
+class ColorizeShader {
+public:
+    ColorizeShader() = default;
+
+    ColorizeShader(const ColorizeShader&) = delete;
+    ColorizeShader& operator=(const ColorizeShader&) = delete;
+
+    ~ColorizeShader() {
+        unload();
+    }
+
+    bool load() {
+        // default raylib vertex shader
+        shader = LoadShaderFromMemory(nullptr, COLORIZE_FS);
+        if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) {
+            shader = {0};
+            return false;
+        }
+
+        gradient_loc = GetShaderLocation(shader, "u_gradient");
+        gradient_mix_loc = GetShaderLocation(shader, "u_gradient_mix");
+        hue_shift_loc = GetShaderLocation(shader, "u_hue_shift");
+        glow_loc = GetShaderLocation(shader, "u_glow");
+        palette_loc = GetShaderLocation(shader, "u_palette");
+        paletted_loc = GetShaderLocation(shader, "u_paletted");
+        return true;
+    }
+
+    void unload() {
+        if (shader.id > 0) {
+            UnloadShader(shader);
+            shader = {0};
+        }
+    }
+
+    bool is_loaded() const {
+        return shader.id > 0;
+    }
+
+    // glow is the additive pass strength, 180/255 matches the old look
+    void begin(const ColorizeConfig& config, double time, float glow) {
+        float gradient[3] = {config.gradient.r / 255.0f, config.gradient.g / 255.0f, config.gradient.b / 255.0f};
+        float gradient_mix = config.use_gradient ? 1.0f : 0.0f;
+        float hue_shift = (float)(time * config.hue_cycle - (long long)(time * config.hue_cycle)) * 6.2831853f;
+
+        SetShaderValue(shader, gradient_loc, gradient, SHADER_UNIFORM_VEC3);
+        SetShaderValue(shader, gradient_mix_loc, &gradient_mix, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, hue_shift_loc, &hue_shift, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, glow_loc, &glow, SHADER_UNIFORM_FLOAT);
+        
+        float paletted = 0.0f;
+        SetShaderValue(shader, paletted_loc, &paletted, SHADER_UNIFORM_FLOAT);
+        bound_palette = 0;
+
+        // rgb is premultiplied by the shader, alpha keeps the old a1*a1 coverage
+        rlSetBlendFactorsSeparate(RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA,
+                                  RL_FUNC_ADD, RL_FUNC_ADD);
+        BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+        BeginShaderMode(shader);
+    }
+
+    // between begin() and end(), switching palettes has to flush the batch
+    void set_palette(const Texture2D& palette) {
+        if (palette.id == bound_palette) {
+            return;
+        }
+        
+        rlDrawRenderBatchActive();
+        float paletted = palette.id > 0 ? 1.0f : 0.0f;
+        SetShaderValue(shader, paletted_loc, &paletted, SHADER_UNIFORM_FLOAT);
+        if (palette.id > 0) {
+            SetShaderValueTexture(shader, palette_loc, palette);
+        }
+        bound_palette = palette.id;
+    }
+    
+    void end() {
+        EndShaderMode();
+        EndBlendMode();
+    }
+
+private:
+    Shader shader = {0};
+    int gradient_loc = -1;
+    int gradient_mix_loc = -1;
+    int hue_shift_loc = -1;
+    int glow_loc = -1;
+    int palette_loc = -1;
+    int paletted_loc = -1;
+    unsigned int bound_palette = 0;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "definitions.h"
+
+struct ControlConfig {
+    bool enabled = false;
+    std::string pipe = "funny-keyboard";    // \\.\pipe\<name>
+};
+
+// local control endpoint on a named pipe, served from its own thread. a
+// client writes requests one per line and gets one reply line for each, one
+// client at a time. the handler runs on the server thread, so whatever it
+// reads or changes has to be safe from there without blocking the others
+class ControlServer {
+public:
+    using Handler = std::function<std::string(const std::string& request)>;
+
+    ControlServer() = default;
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    ~ControlServer() {
+        stop();
+    }
+
+    static std::string pipe_path(const std::string& name) {
+        return "\\\\.\\pipe\\" + name;
+    }
+
+    bool start(const std::string& name, Handler request_handler) {
+        stop();
+
+        handler = std::move(request_handler);
+        path = pipe_path(name);
+        stop_event = CreateEventA(nullptr, 1, 0, nullptr);
+        io_event = CreateEventA(nullptr, 1, 0, nullptr);
+
+        // the first instance is made here so a taken name fails start() and not the thread
+        pipe = (stop_event && io_event) ? create_pipe() : INVALID_HANDLE_VALUE;
+        if (pipe == INVALID_HANDLE_VALUE) {
+            close_events();
+            return false;
+        }
+
+        stopping = false;
+        worker = std::thread(&ControlServer::run, this);
+        return true;
+    }
+
+    // drops a connected client, a request being handled finishes first
+    void stop() {
+        if (!worker.joinable()) return;
+
+        stopping = true;
+        SetEvent(stop_event);
+        worker.join();
+        close_events();
+    }
+
+    bool is_running() const {
+        return worker.joinable();
+    }
+
+    const std::string& get_path() const {
+        return path;
+    }
+
+    uint64_t get_request_count() const {
+        return request_count.load(std::memory_order_relaxed);
+    }
+
+    // client side, sends one request and waits for its reply
+    static bool request(const std::string& name, const std::string& line, std::string& reply) {
+        std::string client_path = pipe_path(name);
+        HANDLE client = CreateFileA(client_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (client == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipeA(client_path.c_str(), CLIENT_WAIT_MS)) {
+            client = CreateFileA(client_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        }
+        if (client == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        std::string message = line + "\n";
+        DWORD written = 0;
+        bool ok = WriteFile(client, message.data(), (DWORD)message.size(), &written, nullptr) && written == message.size();
+
+        reply.clear();
+        char buffer[4096];
+        while (ok) {
+            DWORD read = 0;
+            if (!ReadFile(client, buffer, sizeof(buffer), &read, nullptr) || read == 0) {
+                ok = false;
+                break;
+            }
+            reply.append(buffer, read);
+
+            size_t end = reply.find('\n');
+            if (end != std::string::npos) {
+                reply.resize(end);
+                break;
+            }
+        }
+
+        CloseHandle(client);
+        return ok;
+    }
+
+private:
+    static constexpr DWORD IDLE_TIMEOUT_MS = 5000;     // a silent client gives the pipe up
+    static constexpr DWORD CLIENT_WAIT_MS = 2000;
+    static constexpr size_t MAX_REQUEST = 64 * 1024;
+
+    HANDLE create_pipe() {
+        return CreateNamedPipeA(path.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                1, 4096, 4096, 0, nullptr);
+    }
+
+    void close_events() {
+        if (stop_event) CloseHandle(stop_event);
+        if (io_event) CloseHandle(io_event);
+        stop_event = io_event = nullptr;
+    }
+
+    void run() {
+        while (!stopping) {
+            begin_io();
+            if (wait_io(ConnectNamedPipe(pipe, &overlapped), INFINITE, nullptr)) {
+                serve();
+            }
+            DisconnectNamedPipe(pipe);
+        }
+        CloseHandle(pipe);
+        pipe = INVALID_HANDLE_VALUE;
+    }
+
+    void serve() {
+        std::string pending;
+        char buffer[1024];
+
+        while (!stopping) {
+            DWORD read = 0;
+            begin_io();
+            if (!wait_io(ReadFile(pipe, buffer, sizeof(buffer), nullptr, &overlapped), IDLE_TIMEOUT_MS, &read) || read == 0) {
+                return;
+            }
+            pending.append(buffer, read);
+
+            size_t end;
+            while ((end = pending.find('\n')) != std::string::npos) {
+                std::string line = pending.substr(0, end);
+                pending.erase(0, end + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+
+                std::string reply = handler(line) + "\n";
+                request_count.fetch_add(1, std::memory_order_relaxed);
+
+                begin_io();
+                if (!wait_io(WriteFile(pipe, reply.data(), (DWORD)reply.size(), nullptr, &overlapped), IDLE_TIMEOUT_MS, nullptr)) {
+                    return;
+                }
+            }
+
+            // not speaking the line protocol
+            if (pending.size() > MAX_REQUEST) return;
+        }
+    }
+
+    void begin_io() {
+        overlapped = {};
+        overlapped.hEvent = io_event;
+    }
+
+    // completes an overlapped call, false if it failed, timed out or the
+    // server is stopping
+    bool wait_io(BOOL completed, DWORD timeout_ms, DWORD* bytes) {
+        DWORD transferred = 0;
+        if (!completed) {
+            DWORD error = GetLastError();
+            if (error == ERROR_PIPE_CONNECTED) return true;
+            if (error != ERROR_IO_PENDING) return false;
+
+            HANDLE events[2] = {io_event, stop_event};
+            if (WaitForMultipleObjects(2, events, 0, timeout_ms) != WAIT_OBJECT_0) {
+                // the call still owns the buffer until the cancel lands
+                CancelIo(pipe);
+                GetOverlappedResult(pipe, &overlapped, &transferred, 1);
+                return false;
+            }
+        }
+
+        if (!GetOverlappedResult(pipe, &overlapped, &transferred, 0)) return false;
+        if (bytes) *bytes = transferred;
+        return true;
+    }
+
+    Handler handler;
+    std::string path;
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    HANDLE stop_event = nullptr;
+    HANDLE io_event = nullptr;
+    OVERLAPPED overlapped = {};
+
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> request_count{0};
+};
@@ -1,8 +1,11 @@
+#pragma once
+
 // (blame winapi conflicting, make a PR if you know a better way)
 
 typedef struct HWND__* HWND;
 typedef struct HHOOK__* HHOOK;
 typedef struct HINSTANCE__* HINSTANCE;
+typedef struct HMONITOR__* HMONITOR;
 typedef HINSTANCE HMODULE;
 typedef unsigned long DWORD;
 typedef unsigned char BYTE;
@@ -14,6 +17,8 @@ typedef unsigned long long WPARAM;
 typedef long long LPARAM;
 typedef long long LRESULT;
 typedef void* FARPROC;
+typedef void* HANDLE;
+typedef struct HKL__* HKL;
 
 typedef struct tagKBDLLHOOKSTRUCT {
     DWORD vkCode;
@@ -23,6 +28,61 @@ typedef struct tagKBDLLHOOKSTRUCT {
     DWORD* dwExtraInfo;
 } KBDLLHOOKSTRUCT;
 
+typedef struct tagPOINT {
+    LONG x;
+    LONG y;
+} POINT;
+
+typedef struct tagRECT {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT;
+
+typedef struct tagMSG {
+    HWND hwnd;
+    UINT message;
+    WPARAM wParam;
+    LPARAM lParam;
+    DWORD time;
+    POINT pt;
+    DWORD lPrivate;
+} MSG;
+
+typedef struct tagGUITHREADINFO {
+    DWORD cbSize;
+    DWORD flags;
+    HWND hwndActive;
+    HWND hwndFocus;
+    HWND hwndCapture;
+    HWND hwndMenuOwner;
+    HWND hwndMoveSize;
+    HWND hwndCaret;
+    RECT rcCaret;
+} GUITHREADINFO;
+
+typedef struct _OVERLAPPED {
+    unsigned long long Internal;
+    unsigned long long InternalHigh;
+    DWORD Offset;
+    DWORD OffsetHigh;
+    HANDLE hEvent;
+} OVERLAPPED;
+
+typedef struct _PROCESS_MEMORY_COUNTERS {
+    DWORD cb;
+    DWORD PageFaultCount;
+    unsigned long long PeakWorkingSetSize;
+    unsigned long long WorkingSetSize;
+    unsigned long long QuotaPeakPagedPoolUsage;
+    unsigned long long QuotaPagedPoolUsage;
+    unsigned long long QuotaPeakNonPagedPoolUsage;
+    unsigned long long QuotaNonPagedPoolUsage;
+    unsigned long long PagefileUsage;
+    unsigned long long PeakPagefileUsage;
+} PROCESS_MEMORY_COUNTERS;
+
 typedef LRESULT (__stdcall *HOOKPROC)(int code, WPARAM wParam, LPARAM lParam);
 
 extern "C" {
@@ -42,6 +102,44 @@ extern "C" {
     __declspec(dllimport) BOOL __stdcall InvalidateRect(HWND hWnd, const void* lpRect, BOOL bErase);
     __declspec(dllimport) BOOL __stdcall UpdateWindow(HWND hWnd);
     __declspec(dllimport) int __stdcall MessageBoxA(HWND hWnd, const char* lpText, const char* lpCaption, UINT uType);
+    __declspec(dllimport) HMODULE __stdcall LoadLibraryA(const char* lpLibFileName);
+    __declspec(dllimport) HWND __stdcall GetForegroundWindow(void);
+    __declspec(dllimport) BOOL __stdcall GetWindowRect(HWND hWnd, RECT* lpRect);
+    __declspec(dllimport) HMONITOR __stdcall MonitorFromPoint(POINT pt, DWORD dwFlags);
+    __declspec(dllimport) BOOL __stdcall GetMessageA(MSG* lpMsg, HWND hWnd, UINT wMsgFilterMin, UINT wMsgFilterMax);
+    __declspec(dllimport) BOOL __stdcall TranslateMessage(const MSG* lpMsg);
+    __declspec(dllimport) LRESULT __stdcall DispatchMessageA(const MSG* lpMsg);
+    __declspec(dllimport) BOOL __stdcall PostThreadMessageA(DWORD idThread, UINT Msg, WPARAM wParam, LPARAM lParam);
+    __declspec(dllimport) DWORD __stdcall GetCurrentThreadId(void);
+    __declspec(dllimport) DWORD __stdcall GetTickCount(void);
+    __declspec(dllimport) HANDLE __stdcall CreateFileA(const char* lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode, void* lpSecurityAttributes, DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes, HANDLE hTemplateFile);
+    __declspec(dllimport) DWORD __stdcall GetFileSize(HANDLE hFile, DWORD* lpFileSizeHigh);
+    __declspec(dllimport) HANDLE __stdcall CreateFileMappingA(HANDLE hFile, void* lpFileMappingAttributes, DWORD flProtect, DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow, const char* lpName);
+    __declspec(dllimport) void* __stdcall MapViewOfFile(HANDLE hFileMappingObject, DWORD dwDesiredAccess, DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow, unsigned long long dwNumberOfBytesToMap);
+    __declspec(dllimport) BOOL __stdcall UnmapViewOfFile(const void* lpBaseAddress);
+    __declspec(dllimport) BOOL __stdcall CloseHandle(HANDLE hObject);
+    __declspec(dllimport) BOOL __stdcall AttachConsole(DWORD dwProcessId);
+    __declspec(dllimport) BOOL __stdcall GetGUIThreadInfo(DWORD idThread, GUITHREADINFO* pgui);
+    __declspec(dllimport) BOOL __stdcall ClientToScreen(HWND hWnd, POINT* lpPoint);
+    __declspec(dllimport) short __stdcall GetKeyState(int nVirtKey);
+    __declspec(dllimport) DWORD __stdcall GetWindowThreadProcessId(HWND hWnd, DWORD* lpdwProcessId);
+    __declspec(dllimport) HKL __stdcall GetKeyboardLayout(DWORD idThread);
+    __declspec(dllimport) HANDLE __stdcall CreateNamedPipeA(const char* lpName, DWORD dwOpenMode, DWORD dwPipeMode, DWORD nMaxInstances, DWORD nOutBufferSize, DWORD nInBufferSize, DWORD nDefaultTimeOut, void* lpSecurityAttributes);
+    __declspec(dllimport) BOOL __stdcall ConnectNamedPipe(HANDLE hNamedPipe, OVERLAPPED* lpOverlapped);
+    __declspec(dllimport) BOOL __stdcall DisconnectNamedPipe(HANDLE hNamedPipe);
+    __declspec(dllimport) BOOL __stdcall WaitNamedPipeA(const char* lpNamedPipeName, DWORD nTimeOut);
+    __declspec(dllimport) BOOL __stdcall ReadFile(HANDLE hFile, void* lpBuffer, DWORD nNumberOfBytesToRead, DWORD* lpNumberOfBytesRead, OVERLAPPED* lpOverlapped);
+    __declspec(dllimport) BOOL __stdcall WriteFile(HANDLE hFile, const void* lpBuffer, DWORD nNumberOfBytesToWrite, DWORD* lpNumberOfBytesWritten, OVERLAPPED* lpOverlapped);
+    __declspec(dllimport) BOOL __stdcall GetOverlappedResult(HANDLE hFile, OVERLAPPED* lpOverlapped, DWORD* lpNumberOfBytesTransferred, BOOL bWait);
+    __declspec(dllimport) BOOL __stdcall CancelIo(HANDLE hFile);
+    __declspec(dllimport) HANDLE __stdcall CreateEventA(void* lpEventAttributes, BOOL bManualReset, BOOL bInitialState, const char* lpName);
+    __declspec(dllimport) BOOL __stdcall SetEvent(HANDLE hEvent);
+    __declspec(dllimport) BOOL __stdcall ResetEvent(HANDLE hEvent);
+    __declspec(dllimport) DWORD __stdcall WaitForMultipleObjects(DWORD nCount, const HANDLE* lpHandles, BOOL bWaitAll, DWORD dwMilliseconds);
+    __declspec(dllimport) DWORD __stdcall GetLastError(void);
+    __declspec(dllimport) HANDLE __stdcall GetCurrentProcess(void);
+    __declspec(dllimport) BOOL __stdcall K32GetProcessMemoryInfo(HANDLE Process, PROCESS_MEMORY_COUNTERS* ppsmemCounters, DWORD cb);
+    __declspec(dllimport) int __stdcall ToUnicodeEx(UINT wVirtKey, UINT wScanCode, const BYTE* lpKeyState, wchar_t* pwszBuff, int cchBuff, UINT wFlags, HKL dwhkl);
 }
 #define KF_UP 0x8000
 #define LLKHF_UP (KF_UP >> 8)
@@ -72,6 +170,7 @@ extern "C" {
 
 #define WH_KEYBOARD_LL 13
 #define HC_ACTION 0
+#define WM_QUIT 0x0012
 #define WM_KEYDOWN 0x0100
 #define WM_KEYUP 0x0101
 #define WM_SYSKEYDOWN 0x0104
@@ -90,6 +189,10 @@ extern "C" {
 #define VK_NEXT 0x22
 #define VK_END 0x23
 #define VK_HOME 0x24
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
 #define VK_SNAPSHOT 0x2C
 #define VK_INSERT 0x2D
 #define VK_DELETE 0x2E
@@ -135,5 +238,32 @@ extern "C" {
 #define VK_F23 0x86
 #define VK_F24 0x87
 #define MAPVK_VK_TO_CHAR 2
+#define MONITOR_DEFAULTTONEAREST 0x00000002
+#define MDT_EFFECTIVE_DPI 0
+#define USER_DEFAULT_SCREEN_DPI 96
+#define GENERIC_READ 0x80000000L
+#define GENERIC_WRITE 0x40000000L
+#define FILE_SHARE_READ 0x00000001
+#define FILE_SHARE_WRITE 0x00000002
+#define OPEN_EXISTING 3
+#define OPEN_ALWAYS 4
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define INVALID_HANDLE_VALUE ((HANDLE)(LONG_PTR)-1)
+#define PAGE_READONLY 0x02
+#define PAGE_READWRITE 0x04
+#define FILE_MAP_WRITE 0x0002
+#define FILE_MAP_READ 0x0004
+#define ATTACH_PARENT_PROCESS ((DWORD)-1)
+#define PIPE_ACCESS_DUPLEX 0x00000003
+#define FILE_FLAG_OVERLAPPED 0x40000000
+#define PIPE_TYPE_BYTE 0x00000000
+#define PIPE_READMODE_BYTE 0x00000000
+#define PIPE_WAIT 0x00000000
+#define PIPE_REJECT_REMOTE_CLIENTS 0x00000008
+#define ERROR_PIPE_BUSY 231L
+#define ERROR_PIPE_CONNECTED 535L
+#define ERROR_IO_PENDING 997L
+#define WAIT_OBJECT_0 0x00000000L
+#define INFINITE 0xFFFFFFFF
 #define SM_CXSCREEN 0
 #define SM_CYSCREEN 1
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+
+struct EffectBudgetConfig {
+    int max_effects = 256;          // live effects, the oldest get shed past this
+    float coalesce_window = 0.12f;  // seconds, same key again within this intensifies instead of spawning
+    int max_intensity = 5;
+    float target_frame_ms = 0.0f;   // 0 derives it from the refresh rate
+};
+
+// steps quality down when frames run long and back up once they recover,
+// level 0 is full quality. record_frame() belongs to the render thread, the
+// getters can be read from anywhere
+class QualityController {
+public:
+    static constexpr int MAX_LEVEL = 3;
+    
+    void set_target(float frame_ms) {
+        target_ms = frame_ms > 0.0f ? frame_ms : 1.0f;
+    }
+    
+    void record_frame(float frame_ms) {
+        average_ms += (frame_ms - average_ms) * 0.1f;
+        
+        if (average_ms > target_ms) {
+            recovered_frames = 0;
+            if (++slow_frames >= DEGRADE_AFTER && get_level() < MAX_LEVEL) {
+                level.fetch_add(1, std::memory_order_relaxed);
+                slow_frames = 0;
+                degrade_count++;
+            }
+        } else if (average_ms < target_ms * 0.7f) {
+            slow_frames = 0;
+            if (++recovered_frames >= RECOVER_AFTER && get_level() > 0) {
+                level.fetch_sub(1, std::memory_order_relaxed);
+                recovered_frames = 0;
+            }
+        } else {
+            slow_frames = 0;
+            recovered_frames = 0;
+        }
+    }
+    
+    int get_level() const {
+        return level.load(std::memory_order_relaxed);
+    }
+    
+    // what each level gives up
+    bool glow_pass() const {
+        return get_level() < 1;
+    }
+    
+    float particle_scale() const {
+        static const float scales[MAX_LEVEL + 1] = {1.0f, 0.5f, 0.25f, 0.0f};
+        return scales[get_level()];
+    }
+    
+    int animation_stride() const {
+        static const int strides[MAX_LEVEL + 1] = {1, 1, 2, 0};
+        return strides[get_level()];
+    }
+    
+    unsigned int get_degrade_count() const {
+        return degrade_count;
+    }
+    
+    void reset_counters() {
+        degrade_count = 0;
+    }
+    
+private:
+    static constexpr int DEGRADE_AFTER = 30;
+    static constexpr int RECOVER_AFTER = 120;
+    
+    float target_ms = 20.0f;
+    float average_ms = 0.0f;
+    std::atomic<int> level{0};
+    int slow_frames = 0;
+    int recovered_frames = 0;
+    unsigned int degrade_count = 0;
+};
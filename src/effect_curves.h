@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <raylib.h>
+
+enum class Easing {
+    LINEAR,
+    EASE_IN,        // quadratic
+    EASE_OUT,
+    EASE_IN_OUT,
+    BACK_OUT,       // overshoots then settles
+    ELASTIC_OUT,
+    BOUNCE_OUT,
+    STEP            // holds the previous value until the keyframe
+};
+
+enum CurveChannel {
+    CURVE_ALPHA,
+    CURVE_SCALE,
+    CURVE_ROTATION,     // degrees
+    CURVE_OFFSET_X,     // px at 100% scale
+    CURVE_OFFSET_Y,
+    CURVE_RED,          // color multiplies the effect's tint, 1 leaves it
+    CURVE_GREEN,
+    CURVE_BLUE,
+    CURVE_CHANNELS
+};
+
+// t is 0..1 over the effect's lifetime, ease shapes the segment arriving at this keyframe
+struct Keyframe {
+    float t;
+    float value;
+    Easing ease = Easing::LINEAR;
+};
+
+// what config.json describes, channels without keyframes hold their default
+struct CurveSpec {
+    float duration = 1.0f;
+    std::array<std::vector<Keyframe>, CURVE_CHANNELS> channels;
+
+    // the animation effects always had: fade out and grow by half over a second
+    static CurveSpec standard() {
+        CurveSpec spec;
+        spec.channels[CURVE_ALPHA] = {{0.0f, 1.0f}, {1.0f, 0.0f}};
+        spec.channels[CURVE_SCALE] = {{0.0f, 1.0f}, {1.0f, 1.5f}};
+        return spec;
+    }
+};
+
+// an effect's animated state at one point of its life, fields in CurveChannel
+// order so a table row copies straight into it
+struct CurvePose {
+    float alpha = 1.0f;
+    float scale = 1.0f;
+    float rotation = 0.0f;
+    float offset_x = 0.0f;
+    float offset_y = 0.0f;
+    float red = 255.0f;     // 0..255, multiplies the tint
+    float green = 255.0f;
+    float blue = 255.0f;
+
+    static CurvePose lerp(const CurvePose& a, const CurvePose& b, float t) {
+        CurvePose pose;
+        pose.alpha = a.alpha + (b.alpha - a.alpha) * t;
+        pose.scale = a.scale + (b.scale - a.scale) * t;
+        pose.rotation = a.rotation + (b.rotation - a.rotation) * t;
+        pose.offset_x = a.offset_x + (b.offset_x - a.offset_x) * t;
+        pose.offset_y = a.offset_y + (b.offset_y - a.offset_y) * t;
+        pose.red = a.red + (b.red - a.red) * t;
+        pose.green = a.green + (b.green - a.green) * t;
+        pose.blue = a.blue + (b.blue - a.blue) * t;
+        return pose;
+    }
+};
+
+// a curve set sampled at fixed steps when it's loaded, so evaluating one is
+// a lerp between two adjacent rows whatever the keyframes and easing. rows
+// hold every channel side by side so both sit in one cache line and the lerp
+// is a couple of simd ops. the easing math only ever runs in bake()
+class EffectCurve {
+public:
+    static constexpr int RESOLUTION = 64;   // steps over the lifetime, plenty for a 1 s fade
+
+    EffectCurve() {
+        bake(CurveSpec::standard());
+    }
+
+    explicit EffectCurve(const CurveSpec& spec) {
+        bake(spec);
+    }
+
+    float get_duration() const {
+        return duration;
+    }
+
+    // an effect's pose at spawn, every channel
+    void start(CurvePose& pose) const {
+        static_assert(sizeof(CurvePose) == sizeof(table[0]), "CurvePose must mirror CurveChannel");
+        std::memcpy(&pose, table[0], sizeof(table[0]));
+    }
+
+    // false once the effect has outlived the curve. pose must have come from
+    // start() of this curve, channels it holds constant aren't written again
+    bool evaluate(float elapsed, CurvePose& pose) const {
+        if (fade_and_grow) {
+            // alpha and scale on straight lines and nothing else moving, the
+            // default curve. costs what the hardcoded ramps did
+            float time = elapsed > 0.0f ? elapsed : 0.0f;
+            if (time >= duration) return false;
+            float alpha = origin[CURVE_ALPHA] + slope[CURVE_ALPHA] * time;
+            float scale = origin[CURVE_SCALE] + slope[CURVE_SCALE] * time;
+            pose.alpha = alpha;
+            pose.scale = scale;
+            return true;
+        }
+
+        float position = std::max(elapsed, 0.0f) * steps_per_second;
+        if (position >= (float)RESOLUTION) {
+            return false;
+        }
+
+        int index = (int)position;
+        float fraction = position - (float)index;
+        const float* from = table[index];
+        const float* to = table[index + 1];
+
+        float values[CURVE_CHANNELS];
+        for (int c = 0; c < CURVE_CHANNELS; c++) {
+            values[c] = from[c] + (to[c] - from[c]) * fraction;
+        }
+
+        // bake() already clamped alpha and color, a lerp stays in range
+        std::memcpy(&pose, values, sizeof(values));
+        return true;
+    }
+
+    static float ease(Easing easing, float t) {
+        switch (easing) {
+            case Easing::EASE_IN:
+                return t * t;
+            case Easing::EASE_OUT:
+                return t * (2.0f - t);
+            case Easing::EASE_IN_OUT:
+                return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+            case Easing::BACK_OUT: {
+                const float c1 = 1.70158f, c3 = c1 + 1.0f;
+                float u = t - 1.0f;
+                return 1.0f + c3 * u * u * u + c1 * u * u;
+            }
+            case Easing::ELASTIC_OUT:
+                if (t <= 0.0f || t >= 1.0f) return t;
+                return std::pow(2.0f, -10.0f * t) * std::sin((t * 10.0f - 0.75f) * 2.0943951f) + 1.0f;
+            case Easing::BOUNCE_OUT: {
+                const float n1 = 7.5625f, d1 = 2.75f;
+                if (t < 1.0f / d1) return n1 * t * t;
+                if (t < 2.0f / d1) { t -= 1.5f / d1; return n1 * t * t + 0.75f; }
+                if (t < 2.5f / d1) { t -= 2.25f / d1; return n1 * t * t + 0.9375f; }
+                t -= 2.625f / d1;
+                return n1 * t * t + 0.984375f;
+            }
+            case Easing::STEP:
+                return t < 1.0f ? 0.0f : 1.0f;
+            default:
+                return t;
+        }
+    }
+
+private:
+    static float default_value(int channel) {
+        switch (channel) {
+            case CURVE_ALPHA: case CURVE_SCALE:
+            case CURVE_RED: case CURVE_GREEN: case CURVE_BLUE:
+                return 1.0f;
+            default:
+                return 0.0f;
+        }
+    }
+
+    static float sample(const std::vector<Keyframe>& keys, float t, float fallback) {
+        if (keys.empty()) return fallback;
+        if (t <= keys.front().t) return keys.front().value;
+        if (t >= keys.back().t) return keys.back().value;
+
+        size_t next = 1;
+        while (keys[next].t < t) next++;
+        const Keyframe& a = keys[next - 1];
+        const Keyframe& b = keys[next];
+        float span = b.t - a.t;
+        float local = span > 0.0f ? (t - a.t) / span : 1.0f;
+        return a.value + (b.value - a.value) * ease(b.ease, local);
+    }
+
+    void bake(const CurveSpec& spec) {
+        duration = std::max(spec.duration, 0.01f);
+        steps_per_second = RESOLUTION / duration;
+
+        for (int c = 0; c < CURVE_CHANNELS; c++) {
+            std::vector<Keyframe> keys = spec.channels[c];
+            std::stable_sort(keys.begin(), keys.end(), [](const Keyframe& a, const Keyframe& b) { return a.t < b.t; });
+
+            // one past the end so the lerp in evaluate() never needs a bounds check
+            for (int i = 0; i <= RESOLUTION; i++) {
+                float value = sample(keys, (float)i / RESOLUTION, default_value(c));
+                if (c == CURVE_ALPHA) {
+                    value = std::clamp(value, 0.0f, 1.0f);
+                } else if (c >= CURVE_RED) {
+                    value = std::clamp(value, 0.0f, 1.0f) * 255.0f;
+                }
+                table[i][c] = value;
+            }
+        }
+
+        fade_and_grow = true;
+        for (int c = 0; c < CURVE_CHANNELS; c++) {
+            float first = table[0][c];
+            float last = table[RESOLUTION][c];
+            bool moving = c == CURVE_ALPHA || c == CURVE_SCALE;
+            float tolerance = 1.0e-5f * std::max(1.0f, std::fabs(last - first));
+            for (int i = 1; i <= RESOLUTION && fade_and_grow; i++) {
+                float line = moving ? first + (last - first) * ((float)i / RESOLUTION) : first;
+                fade_and_grow = std::fabs(table[i][c] - line) <= tolerance;
+            }
+            origin[c] = first;
+            slope[c] = (last - first) / duration;
+        }
+    }
+
+    float duration = 1.0f;
+    float steps_per_second = RESOLUTION;
+    bool fade_and_grow = false;
+    float origin[CURVE_CHANNELS];   // value at 0 and change per second, for the fade_and_grow path
+    float slope[CURVE_CHANNELS];
+    alignas(32) float table[RESOLUTION + 1][CURVE_CHANNELS];
+};
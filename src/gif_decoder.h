@@ -0,0 +1,339 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <raylib.h>
+
+// streams the frames of a gif one at a time into a single canvas of the
+// logical screen size, applying each frame's disposal before the next one.
+// the caller owns the file data and consumes the canvas after every
+// next_frame(), nothing per frame is allocated
+class GifDecoder {
+public:
+    bool open(const unsigned char* file_data, size_t file_size) {
+        data = file_data;
+        size = file_size;
+        pos = 0;
+
+        if (size < 13 || (std::memcmp(data, "GIF87a", 6) != 0 && std::memcmp(data, "GIF89a", 6) != 0)) {
+            return false;
+        }
+
+        width = read_u16(6);
+        height = read_u16(8);
+        uint8_t flags = data[10];
+        pos = 13;
+        if (width <= 0 || height <= 0 || (size_t)width * height > MAX_PIXELS) {
+            return false;
+        }
+
+        global_colors = 0;
+        if (flags & 0x80) {
+            global_colors = 2 << (flags & 0x07);
+            if (!read_palette(global_palette, global_colors)) {
+                return false;
+            }
+        }
+
+        canvas.assign((size_t)width * height, Color{0, 0, 0, 0});
+        dispose = {};
+        return true;
+    }
+
+    int get_width() const {
+        return width;
+    }
+
+    int get_height() const {
+        return height;
+    }
+
+    // decodes the next frame on top of the canvas, false at the end of the
+    // file or on corrupt data. delay is in seconds
+    bool next_frame(float& delay) {
+        apply_disposal();
+
+        int delay_cs = 0;
+        int disposal = 0;
+        int transparent = -1;
+
+        while (pos < size) {
+            uint8_t block = data[pos++];
+
+            if (block == 0x21) {
+                if (pos >= size) return false;
+                uint8_t label = data[pos++];
+                if (label == 0xF9 && pos + 5 < size && data[pos] == 4) {
+                    // graphic control extension, applies to the next image
+                    uint8_t gce = data[pos + 1];
+                    disposal = (gce >> 2) & 0x07;
+                    delay_cs = read_u16(pos + 2);
+                    if (gce & 0x01) {
+                        transparent = data[pos + 4];
+                    }
+                }
+                if (!skip_sub_blocks()) return false;
+            } else if (block == 0x2C) {
+                if (!decode_image(transparent, disposal)) return false;
+                // most viewers treat 0 and 1 centiseconds as the default 100 ms
+                delay = delay_cs <= 1 ? 0.1f : delay_cs / 100.0f;
+                return true;
+            } else {
+                // 0x3B trailer, or garbage past the last frame
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // width*height rgba, valid until the next next_frame()
+    const Color* get_canvas() const {
+        return canvas.data();
+    }
+
+private:
+    // as many pixels as 4096 x 4096, a 64 MiB canvas. anything bigger is not
+    // an effect sprite
+    static constexpr size_t MAX_PIXELS = 1u << 24;
+    static constexpr int MAX_CODES = 4096;
+
+    struct Disposal {
+        int method = 0;
+        int x = 0, y = 0, w = 0, h = 0;
+    };
+
+    int read_u16(size_t at) const {
+        return data[at] | (data[at + 1] << 8);
+    }
+
+    bool read_palette(Color* palette, int count) {
+        if (pos + (size_t)count * 3 > size) return false;
+        for (int i = 0; i < count; i++) {
+            palette[i] = {data[pos], data[pos + 1], data[pos + 2], 255};
+            pos += 3;
+        }
+        return true;
+    }
+
+    bool skip_sub_blocks() {
+        while (pos < size) {
+            uint8_t length = data[pos++];
+            if (length == 0) return true;
+            pos += length;
+        }
+        return false;
+    }
+
+    // undoes the previous frame as its disposal method asks
+    void apply_disposal() {
+        if (dispose.method == 2) {
+            // restore to background, every viewer clears to transparent
+            for (int y = dispose.y; y < dispose.y + dispose.h; y++) {
+                std::fill_n(&canvas[(size_t)y * width + dispose.x], dispose.w, Color{0, 0, 0, 0});
+            }
+        } else if (dispose.method == 3) {
+            for (int y = 0; y < dispose.h; y++) {
+                std::copy_n(&saved[(size_t)y * dispose.w], dispose.w, &canvas[(size_t)(dispose.y + y) * width + dispose.x]);
+            }
+        }
+        dispose = {};
+    }
+
+    bool decode_image(int transparent, int disposal) {
+        if (pos + 9 > size) return false;
+        int frame_x = read_u16(pos);
+        int frame_y = read_u16(pos + 2);
+        int frame_w = read_u16(pos + 4);
+        int frame_h = read_u16(pos + 6);
+        uint8_t flags = data[pos + 8];
+        pos += 9;
+
+        const Color* palette = global_palette;
+        int colors = global_colors;
+        if (flags & 0x80) {
+            colors = 2 << (flags & 0x07);
+            if (!read_palette(local_palette, colors)) return false;
+            palette = local_palette;
+        }
+        if (colors == 0) return false;
+
+        // the part of the frame that is on the canvas
+        int clip_x = std::min(frame_x, width), clip_y = std::min(frame_y, height);
+        int clip_w = std::min(frame_x + frame_w, width) - clip_x;
+        int clip_h = std::min(frame_y + frame_h, height) - clip_y;
+        if (clip_w <= 0 || clip_h <= 0) {
+            clip_x = clip_y = clip_w = clip_h = 0;
+        }
+
+        dispose = {disposal, clip_x, clip_y, clip_w, clip_h};
+        if (disposal == 3) {
+            saved.resize((size_t)clip_w * clip_h);
+            for (int y = 0; y < clip_h; y++) {
+                std::copy_n(&canvas[(size_t)(clip_y + y) * width + clip_x], clip_w, &saved[(size_t)y * clip_w]);
+            }
+        }
+
+        if (pos >= size) return false;
+        int min_code_size = data[pos++];
+        if (min_code_size < 2 || min_code_size > 8) return false;
+
+        FrameWriter out = {this, palette, colors, transparent, frame_x, frame_y, frame_w, frame_h, (flags & 0x40) != 0};
+        bool ok = decode_lzw(min_code_size, out);
+
+        // whatever is left of the image data, also after an early end code
+        return skip_sub_blocks() && ok;
+    }
+
+    // pixels arrive in raster (or interlaced) order, written straight into the canvas
+    struct FrameWriter {
+        GifDecoder* decoder;
+        const Color* palette;
+        int colors;
+        int transparent;
+        int frame_x, frame_y, frame_w, frame_h;
+        bool interlaced;
+        int x = 0, y = 0, pass = 0;
+
+        bool done() const {
+            return y >= frame_h;
+        }
+
+        void put(uint8_t index) {
+            int canvas_x = frame_x + x, canvas_y = frame_y + y;
+            if (index != transparent && index < colors && canvas_x < decoder->width && canvas_y < decoder->height) {
+                decoder->canvas[(size_t)canvas_y * decoder->width + canvas_x] = palette[index];
+            }
+            if (++x < frame_w) return;
+
+            x = 0;
+            if (!interlaced) {
+                y++;
+                return;
+            }
+            // rows 0, 8, 16.. then 4, 12.. then 2, 6.. then 1, 3..
+            static constexpr int START[4] = {0, 4, 2, 1};
+            static constexpr int STEP[4] = {8, 8, 4, 2};
+            y += STEP[pass];
+            while (y >= frame_h && ++pass < 4) {
+                y = START[pass];
+            }
+        }
+    };
+
+    // variable width lzw, codes read lsb first across the data sub-blocks
+    bool decode_lzw(int min_code_size, FrameWriter& out) {
+        const int clear_code = 1 << min_code_size;
+        const int end_code = clear_code + 1;
+
+        int code_size = min_code_size + 1;
+        int next_code = end_code + 1;
+        int previous = -1;
+
+        uint32_t bits = 0;
+        int bit_count = 0;
+        int block_left = 0;
+
+        for (int i = 0; i < clear_code; i++) {
+            prefix[i] = -1;
+            suffix[i] = (uint8_t)i;
+            first[i] = (uint8_t)i;
+            length[i] = 1;
+        }
+
+        while (!out.done()) {
+            while (bit_count < code_size) {
+                if (block_left == 0) {
+                    if (pos >= size || data[pos] == 0) return false;
+                    block_left = data[pos++];
+                }
+                if (pos >= size) return false;
+                bits |= (uint32_t)data[pos++] << bit_count;
+                bit_count += 8;
+                block_left--;
+            }
+
+            int code = bits & ((1 << code_size) - 1);
+            bits >>= code_size;
+            bit_count -= code_size;
+
+            if (code == clear_code) {
+                code_size = min_code_size + 1;
+                next_code = end_code + 1;
+                previous = -1;
+                continue;
+            }
+            if (code == end_code) {
+                break;
+            }
+
+            int emitted;
+            if (previous < 0) {
+                if (code >= clear_code) return false;
+                emitted = code;
+            } else if (code < next_code) {
+                emitted = code;
+                add_code(next_code, previous, first[code]);
+            } else if (code == next_code && next_code < MAX_CODES) {
+                // the kwkwk case, the code being defined is the one read
+                add_code(next_code, previous, first[previous]);
+                emitted = code;
+            } else {
+                return false;
+            }
+
+            if (previous >= 0 && next_code < MAX_CODES) {
+                next_code++;
+                if (next_code == (1 << code_size) && code_size < 12) {
+                    code_size++;
+                }
+            }
+            previous = code;
+
+            // codes are chains back to a root, unwind them into a stack first
+            int count = length[emitted];
+            int at = emitted;
+            for (int i = count - 1; i >= 0; i--) {
+                stack[i] = suffix[at];
+                at = prefix[at];
+            }
+            for (int i = 0; i < count && !out.done(); i++) {
+                out.put(stack[i]);
+            }
+        }
+
+        // rest of the current sub-block, the ones after it are skipped by the caller.
+        // a short final row is fine, the rest of the frame keeps the canvas
+        pos += block_left;
+        return true;
+    }
+
+    void add_code(int code, int previous, uint8_t last) {
+        if (code >= MAX_CODES) return;
+        prefix[code] = (int16_t)previous;
+        suffix[code] = last;
+        first[code] = first[previous];
+        length[code] = (uint16_t)(length[previous] + 1);
+    }
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+
+    int width = 0;
+    int height = 0;
+    Color global_palette[256];
+    Color local_palette[256];
+    int global_colors = 0;
+
+    std::vector<Color> canvas;
+    std::vector<Color> saved;       // under the current frame, for disposal 3
+    Disposal dispose;
+
+    int16_t prefix[MAX_CODES];
+    uint8_t suffix[MAX_CODES];
+    uint8_t first[MAX_CODES];
+    uint16_t length[MAX_CODES];
+    uint8_t stack[MAX_CODES];
+};
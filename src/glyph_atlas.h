@@ -0,0 +1,240 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <raylib.h>
+
+// glyphs are rasterized the first time a label needs them into fixed size
+// cells of one texture, the least recently drawn cell is reused when it's
+// full. the atlas doubles as a raylib Font so DrawTextEx/MeasureTextEx work
+// on it unchanged (GetGlyphIndex scans glyphs linearly and falls back to '?')
+class GlyphAtlas {
+public:
+    GlyphAtlas() = default;
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    ~GlyphAtlas() {
+        unload();
+    }
+
+    // font_paths are tried in order for every glyph, so later ones only fill in
+    // what the earlier ones lack. needs the gl context
+    bool load(const std::vector<std::string>& font_paths, int glyph_size = 64, int texture_size = 1024) {
+        for (const auto& path : font_paths) {
+            int data_size = 0;
+            unsigned char* data = LoadFileData(path.c_str(), &data_size);
+            if (data && data_size > 0) {
+                fonts.push_back({data, data_size});
+            } else if (data) {
+                UnloadFileData(data);
+            }
+        }
+        if (fonts.empty()) {
+            return false;
+        }
+
+        size = glyph_size;
+        cell = glyph_size + glyph_size / 8 + 2;
+        columns = texture_size / cell;
+        int capacity = columns * columns;
+        if (capacity < 2) {
+            unload();
+            return false;
+        }
+
+        Image blank = GenImageColor(texture_size, texture_size, BLANK);
+        font.texture = LoadTextureFromImage(blank);
+        UnloadImage(blank);
+        if (font.texture.id == 0) {
+            unload();
+            return false;
+        }
+
+        recs.assign(capacity, Rectangle{0, 0, 0, 0});
+        glyphs.assign(capacity, GlyphInfo{});
+        cells.assign(capacity, Cell{});
+        pixels.assign((size_t)cell * cell * 4, 0);
+
+        font.baseSize = glyph_size;
+        font.glyphCount = capacity;
+        font.glyphPadding = 0;
+        font.recs = recs.data();
+        font.glyphs = glyphs.data();
+
+        // '?' is what raylib draws for anything missing, it lives in cell 0 for good
+        for (int i = 1; i < capacity; i++) {
+            glyphs[i].value = -1;
+            cells[i].lru = lru.insert(lru.end(), i);
+        }
+        rasterize(0, '?');
+        return true;
+    }
+
+    void unload() {
+        if (font.texture.id > 0) {
+            UnloadTexture(font.texture);
+        }
+        for (const auto& source : fonts) {
+            UnloadFileData(source.data);
+        }
+        fonts.clear();
+        font = {};
+        lru.clear();
+        cached.clear();
+        missing.clear();
+    }
+
+    bool is_loaded() const {
+        return font.texture.id > 0;
+    }
+
+    // render thread, makes every codepoint of a utf-8 label drawable this frame.
+    // a label is drawn every frame it's on screen, so hits and misses are only
+    // counted on its first one (first_use) to say how often a new label finds
+    // its glyphs cached
+    void prepare(const std::string& text, uint64_t frame, bool first_use) {
+        const char* cursor = text.c_str();
+        while (*cursor) {
+            int bytes = 0;
+            int codepoint = GetCodepointNext(cursor, &bytes);
+            cursor += bytes > 0 ? bytes : 1;
+            if (codepoint == '?' || codepoint < 32 || missing.count(codepoint)) continue;
+
+            auto it = cached.find(codepoint);
+            if (it != cached.end()) {
+                if (first_use) hits++;
+                touch(it->second, frame);
+                continue;
+            }
+
+            if (first_use) misses++;
+            int victim = lru.back();
+            if (cells[victim].frame == frame && glyphs[victim].value >= 0) {
+                // every cell is on screen right now, this one shows as '?'
+                continue;
+            }
+
+            if (glyphs[victim].value >= 0) {
+                cached.erase(glyphs[victim].value);
+                evictions++;
+            }
+            if (rasterize(victim, codepoint)) {
+                cached[codepoint] = victim;
+                touch(victim, frame);
+            } else {
+                // no font has it, don't try again every frame
+                missing.insert(codepoint);
+            }
+        }
+    }
+
+    const Font& get_font() const {
+        return font;
+    }
+
+    uint64_t get_hits() const {
+        return hits;
+    }
+
+    uint64_t get_misses() const {
+        return misses;
+    }
+
+    uint64_t get_evictions() const {
+        return evictions;
+    }
+
+    double get_hit_rate() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 1.0 : (double)hits / total;
+    }
+
+private:
+    struct FontSource {
+        unsigned char* data;
+        int size;
+    };
+
+    struct Cell {
+        std::list<int>::iterator lru;
+        uint64_t frame = ~0ull;
+    };
+
+    void touch(int index, uint64_t frame) {
+        cells[index].frame = frame;
+        if (index != 0) {
+            lru.splice(lru.begin(), lru, cells[index].lru);
+        }
+    }
+
+    // first font that has the glyph wins, false leaves the cell empty
+    bool rasterize(int index, int codepoint) {
+        GlyphInfo* glyph = nullptr;
+        for (const auto& source : fonts) {
+            glyph = LoadFontData(source.data, source.size, size, &codepoint, 1, FONT_DEFAULT);
+            if (glyph && (glyph->image.data || codepoint == ' ')) break;
+            if (glyph) UnloadFontData(glyph, 1);
+            glyph = nullptr;
+        }
+
+        // clear the whole cell so nothing of the previous glyph is left
+        std::fill(pixels.begin(), pixels.end(), 0);
+        int width = 0, height = 0;
+        if (glyph && glyph->image.data) {
+            width = std::min(glyph->image.width, cell - 2);
+            height = std::min(glyph->image.height, cell - 2);
+            const unsigned char* coverage = (const unsigned char*)glyph->image.data;
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    unsigned char* out = &pixels[((size_t)(y + 1) * cell + x + 1) * 4];
+                    out[0] = out[1] = out[2] = 255;
+                    out[3] = coverage[y * glyph->image.width + x];
+                }
+            }
+        }
+
+        float cell_x = (float)(index % columns * cell);
+        float cell_y = (float)(index / columns * cell);
+        UpdateTextureRec(font.texture, {cell_x, cell_y, (float)cell, (float)cell}, pixels.data());
+
+        if (!glyph) {
+            glyphs[index].value = -1;
+            recs[index] = {0, 0, 0, 0};
+            return false;
+        }
+
+        glyphs[index].value = codepoint;
+        glyphs[index].offsetX = glyph->offsetX;
+        glyphs[index].offsetY = glyph->offsetY;
+        glyphs[index].advanceX = glyph->advanceX;
+        recs[index] = {cell_x + 1, cell_y + 1, (float)width, (float)height};
+        UnloadFontData(glyph, 1);
+        return true;
+    }
+
+    std::vector<FontSource> fonts;
+    int size = 64;
+    int cell = 0;
+    int columns = 0;
+
+    Font font = {};
+    std::vector<Rectangle> recs;
+    std::vector<GlyphInfo> glyphs;
+    std::vector<Cell> cells;
+    std::list<int> lru;                         // most recently drawn first, cell 0 is never in it
+    std::unordered_map<int, int> cached;        // codepoint -> cell
+    std::unordered_set<int> missing;            // in none of the fonts, drawn as '?'
+    std::vector<unsigned char> pixels;          // one cell, rgba
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sstream>
+
+// power of two buckets in microseconds, bucket i holds [2^i, 2^(i+1)),
+// safe to record from one thread while another reads
+class LatencyHistogram {
+public:
+    static constexpr int BUCKETS = 24;
+    
+    void record_us(uint64_t us) {
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && (us >> (bucket + 1)) != 0) {
+            bucket++;
+        }
+        
+        counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum_us.fetch_add(us, std::memory_order_relaxed);
+        
+        uint64_t previous_max = max_us.load(std::memory_order_relaxed);
+        while (us > previous_max && !max_us.compare_exchange_weak(previous_max, us, std::memory_order_relaxed)) {}
+    }
+    
+    uint64_t get_count() const {
+        return total.load(std::memory_order_relaxed);
+    }
+    
+    double get_average_us() const {
+        uint64_t n = get_count();
+        return n == 0 ? 0.0 : (double)sum_us.load(std::memory_order_relaxed) / n;
+    }
+    
+    uint64_t get_max_us() const {
+        return max_us.load(std::memory_order_relaxed);
+    }
+    
+    // upper edge of the bucket holding the p-th fraction of samples
+    uint64_t percentile_us(double p) const {
+        uint64_t n = get_count();
+        if (n == 0) return 0;
+        
+        uint64_t target = (uint64_t)(p * n);
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                return (uint64_t)1 << (i + 1);
+            }
+        }
+        return get_max_us();
+    }
+    
+    std::string summary() const {
+        std::ostringstream oss;
+        oss << get_count() << " samples, avg " << (uint64_t)get_average_us() << " us"
+            << ", p50 <= " << percentile_us(0.50) << " us"
+            << ", p99 <= " << percentile_us(0.99) << " us"
+            << ", max " << get_max_us() << " us";
+        return oss.str();
+    }
+    
+    void reset() {
+        for (auto& count : counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        sum_us.store(0, std::memory_order_relaxed);
+        max_us.store(0, std::memory_order_relaxed);
+    }
+    
+private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum_us{0};
+    std::atomic<uint64_t> max_us{0};
+};
@@ -7,10 +7,22 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <cstdio>
+#include <thread>
+#include <future>
 
 #include <nlohmann/json.hpp>
 #include "renderer.h"
 #include "definitions.h"
+#include "latency_histogram.h"
+#include "sample_cache.h"
+#include "streaming_audio.h"
+#include "click_synth.h"
+#include "trigger_engine.h"
+#include "typing_stats.h"
+#include "overlay_capture.h"
+#include "control_server.h"
+#include "triple_buffer.h"
 using json = nlohmann::json;
 
 // logging macros based on build configuration
@@ -42,18 +54,56 @@ using json = nlohmann::json;
 #endif
 
 static HHOOK g_keyboard_hook = nullptr;
+static std::thread g_input_thread;
+static DWORD g_input_thread_id = 0;
+static LatencyHistogram g_hook_latency;
 static std::atomic<bool> g_running{true};
+static std::atomic<bool> g_capture_toggle{false};   // set by the hook, the render thread starts/stops
 static std::set<DWORD> g_pressed_keys;
 static std::mutex g_keys_mutex;
-static float g_volume = 1.0f;
+static std::atomic<float> g_volume{1.0f};
+
+// a chord ("ctrl+s") or a sequence ("g g", "gg") and what it does
+struct BindingConfig {
+    std::string chord;
+    std::string sequence;
+    std::string action;         // "exit", "capture", anything else shows the effect below
+    std::string sound;
+    bool synth = false;
+    ClickSynthParams synth_params;
+    std::string text;
+};
 
 struct Config {
     float volume = 0.5f;
     std::string main_sound = "assets/main.wav";
     std::map<std::string, std::string> per_key_overrides;
+    std::map<std::string, ClickSynthParams> synth_overrides;
+    bool main_synth = false;
+    ClickSynthParams main_synth_params;
+    std::vector<BindingConfig> bindings;
+    std::string stats_file = "stats.bin";   // empty disables
     std::vector<std::string> images;
     std::string font = "";
+    std::vector<std::string> fallback_fonts;    // for characters the font lacks, empty disables the glyph atlas
+    int glyph_size = 64;
     std::string colorize = "";
+    ColorizeConfig colorize_config;
+    std::vector<EmitterConfig> emitters;
+    int simulation_rate = 120;
+    std::vector<int> monitors = {0}; // empty means all
+    bool route_to_all_monitors = false;
+    EffectBudgetConfig budget;
+    StreamingConfig streaming;
+    PlacementConfig placement;
+    CaptureConfig capture;
+    ControlConfig control;
+    CurveSpec default_curve = CurveSpec::standard();
+    std::map<std::string, CurveSpec> key_curves;
+    bool input_thread = true;
+    TextureOptions texture_options;
+    bool low_latency = false;
+    bool latency_report = false;
     
     Config() {
         per_key_overrides["enter"] = "assets/enter.wav";
@@ -63,14 +113,83 @@ struct Config {
         images.push_back("assets/fire3.webp");
         colorize = "#2AD317";
         font = "C:\\Windows\\Fonts\\MTCORSVA.TTF";
+        fallback_fonts = {"C:\\Windows\\Fonts\\segoeui.ttf", "C:\\Windows\\Fonts\\arial.ttf", "C:\\Windows\\Fonts\\malgun.ttf"};
+        emitters.push_back(EmitterConfig());
+        
+        BindingConfig exit_binding;
+        exit_binding.chord = "ctrl+alt+f";
+        exit_binding.action = "exit";
+        bindings.push_back(exit_binding);
     }
 };
 
+static SampleCache g_samples;
+static SoundStreamer g_streamer;
 static Sound g_main_sound;
+static StreamedSound* g_main_stream = nullptr;
 static std::map<std::string, Sound> g_key_sounds;
+static std::map<std::string, StreamedSound*> g_key_streams;
+static ClickSynth g_synth;
+static int g_main_synth = -1;
+static std::map<std::string, int> g_key_synths;
+
+struct BindingAction {
+    bool exit = false;
+    bool capture = false;
+    bool chord = false;     // chords replace the key's own sound and effect
+    Sound sound = {};
+    int synth = -1;
+    std::string text;
+};
+
+static TypingStats g_stats;
+static TriggerEngine g_triggers;
+static std::vector<BindingAction> g_binding_actions;
 
 static KeyRenderer* g_renderer = nullptr;
 
+struct LatencySummary {
+    double average_us = 0.0;
+    uint64_t p99_us = 0;
+    uint64_t max_us = 0;
+    uint64_t count = 0;
+};
+
+// what the control endpoint reports, the render thread publishes it every
+// frame and the control thread only ever reads the latest one
+struct OverlayStats {
+    uint64_t frames = 0;
+    float frame_ms = 0.0f;          // present to present
+    float frame_average_ms = 0.0f;
+    float frame_max_ms = 0.0f;
+    int quality_level = 0;
+    unsigned int quality_drops = 0;
+    size_t effects = 0;
+    uint64_t ticks = 0;
+    double step_us = 0.0;
+    uint64_t coalesced = 0;
+    uint64_t shed = 0;
+    LatencySummary present_latency;
+    LatencySummary hook_latency;
+    int synth_voices = 0;
+    size_t stream_voices_playing = 0;
+    size_t stream_voices = 0;
+    unsigned long long stream_steals = 0;
+    unsigned long long stream_drops = 0;
+    size_t texture_bytes = 0;
+    size_t sample_bytes = 0;
+    size_t stream_bytes = 0;
+};
+
+static TripleBuffer<OverlayStats> g_overlay_stats;
+static TripleBuffer<ColorizeConfig> g_colorize_requests;    // control thread -> render thread
+static ColorizeConfig g_control_colorize;                   // control thread only, what it last sent
+static std::atomic<bool> g_reset_counters{false};
+static std::vector<OutputRegion> g_outputs;
+static OutputBounds g_output_bounds = {0, 0, 0, 0};
+static bool g_route_to_all_monitors = false;
+static bool g_place_near_caret = false;
+
 Color parse_hex_color(const std::string& hex_str) {
     if (hex_str == "false" || hex_str == "False" || hex_str == "FALSE") {
         return Color{255, 255, 255, 255};
@@ -96,6 +215,168 @@ Color parse_hex_color(const std::string& hex_str) {
     }
 }
 
+std::string color_to_hex(Color color)
+{
+    char buffer[8];
+    snprintf(buffer, sizeof(buffer), "#%02X%02X%02X", color.r, color.g, color.b);
+    return buffer;
+}
+
+EmitterConfig parse_emitter_config(const json& j)
+{
+    EmitterConfig emitter;
+    
+    emitter.name = j.value("name", emitter.name);
+    emitter.count = j.value("count", emitter.count);
+    emitter.capacity = j.value("capacity", emitter.capacity);
+    emitter.lifetime = j.value("lifetime", emitter.lifetime);
+    emitter.speed = j.value("speed", emitter.speed);
+    emitter.spread = j.value("spread", emitter.spread);
+    emitter.gravity = j.value("gravity", emitter.gravity);
+    emitter.size = j.value("size", emitter.size);
+    emitter.additive = j.value("additive", emitter.additive);
+    
+    if (j.contains("color")) {
+        emitter.color = parse_hex_color(j["color"].get<std::string>());
+    }
+    
+    return emitter;
+}
+
+// {"synth": {...}} in place of a sound file
+ClickSynthParams parse_synth_params(const json& j)
+{
+    ClickSynthParams params;
+    const json& synth = j.contains("synth") ? j["synth"] : j;
+    
+    params.pitch = synth.value("pitch", params.pitch);
+    params.body_decay_ms = synth.value("body_decay_ms", params.body_decay_ms);
+    params.noise = synth.value("noise", params.noise);
+    params.noise_decay_ms = synth.value("noise_decay_ms", params.noise_decay_ms);
+    params.gain = synth.value("gain", params.gain);
+    params.randomize = synth.value("randomize", params.randomize);
+    
+    return params;
+}
+
+static Easing parse_easing(const std::string& name)
+{
+    if (name == "ease_in") return Easing::EASE_IN;
+    if (name == "ease_out") return Easing::EASE_OUT;
+    if (name == "ease_in_out") return Easing::EASE_IN_OUT;
+    if (name == "back_out") return Easing::BACK_OUT;
+    if (name == "elastic_out") return Easing::ELASTIC_OUT;
+    if (name == "bounce_out") return Easing::BOUNCE_OUT;
+    if (name == "step") return Easing::STEP;
+    return Easing::LINEAR;
+}
+
+// keyframes are [t, value], [t, value, "ease"] or {"t", "value", "ease"}. for
+// "color" the value is a hex color, split over the three color channels
+static void parse_keyframes(const json& j, CurveSpec& spec, int channel, bool color)
+{
+    int channels = color ? 3 : 1;
+    for (int c = 0; c < channels; c++) {
+        spec.channels[channel + c].clear();
+    }
+    
+    for (const auto& key : j) {
+        json t, value;
+        std::string ease;
+        if (key.is_array() && key.size() >= 2) {
+            t = key[0];
+            value = key[1];
+            if (key.size() >= 3) ease = key[2].get<std::string>();
+        } else if (key.is_object()) {
+            t = key.value("t", json(0.0f));
+            value = key.value("value", json());
+            ease = key.value("ease", std::string());
+        } else {
+            continue;
+        }
+        if (!t.is_number()) continue;
+        
+        if (color && value.is_string()) {
+            Color parsed = parse_hex_color(value.get<std::string>());
+            unsigned char components[3] = {parsed.r, parsed.g, parsed.b};
+            for (int c = 0; c < 3; c++) {
+                spec.channels[channel + c].push_back({t.get<float>(), components[c] / 255.0f, parse_easing(ease)});
+            }
+        } else if (!color && value.is_number()) {
+            spec.channels[channel].push_back({t.get<float>(), value.get<float>(), parse_easing(ease)});
+        }
+    }
+}
+
+// channels the curve leaves out keep base's
+static CurveSpec parse_curve_spec(const json& j, const CurveSpec& base)
+{
+    static const std::pair<const char*, int> CHANNEL_NAMES[] = {
+        {"alpha", CURVE_ALPHA}, {"scale", CURVE_SCALE}, {"rotation", CURVE_ROTATION},
+        {"offset_x", CURVE_OFFSET_X}, {"offset_y", CURVE_OFFSET_Y}
+    };
+    
+    CurveSpec spec = base;
+    spec.duration = j.value("duration", spec.duration);
+    for (const auto& [name, channel] : CHANNEL_NAMES) {
+        if (j.contains(name) && j[name].is_array()) {
+            parse_keyframes(j[name], spec, channel, false);
+        }
+    }
+    if (j.contains("color") && j["color"].is_array()) {
+        parse_keyframes(j["color"], spec, CURVE_RED, true);
+    }
+    return spec;
+}
+
+BindingConfig parse_binding_config(const json& j)
+{
+    BindingConfig binding;
+    
+    binding.chord = j.value("chord", binding.chord);
+    binding.sequence = j.value("sequence", binding.sequence);
+    binding.action = j.value("action", binding.action);
+    binding.text = j.value("text", binding.text);
+    
+    if (j.contains("sound")) {
+        if (j["sound"].is_object()) {
+            binding.synth = true;
+            binding.synth_params = parse_synth_params(j["sound"]);
+        } else {
+            binding.sound = j["sound"].get<std::string>();
+        }
+    }
+    
+    return binding;
+}
+
+json binding_config_to_json(const BindingConfig& binding)
+{
+    json j;
+    if (!binding.chord.empty()) j["chord"] = binding.chord;
+    if (!binding.sequence.empty()) j["sequence"] = binding.sequence;
+    if (!binding.action.empty()) j["action"] = binding.action;
+    if (!binding.sound.empty()) j["sound"] = binding.sound;
+    if (!binding.text.empty()) j["text"] = binding.text;
+    return j;
+}
+
+json emitter_config_to_json(const EmitterConfig& emitter)
+{
+    json j;
+    j["name"] = emitter.name;
+    j["count"] = emitter.count;
+    j["capacity"] = emitter.capacity;
+    j["lifetime"] = emitter.lifetime;
+    j["speed"] = emitter.speed;
+    j["spread"] = emitter.spread;
+    j["gravity"] = emitter.gravity;
+    j["size"] = emitter.size;
+    j["additive"] = emitter.additive;
+    j["color"] = color_to_hex(emitter.color);
+    return j;
+}
+
 void save_default_config(const std::string& filename)
 {
     Config default_config;
@@ -108,6 +389,64 @@ void save_default_config(const std::string& filename)
     j["font"] = default_config.font;
     j["colorize"] = default_config.colorize;
     j["font"] = default_config.font;
+    j["fallback_fonts"] = default_config.fallback_fonts;
+    j["glyph_size"] = default_config.glyph_size;
+    
+    j["simulation_rate"] = default_config.simulation_rate;
+    j["image_size"] = default_config.texture_options.size;
+    j["texture_storage"] = "rgba";
+    j["input_thread"] = default_config.input_thread;
+    j["low_latency"] = default_config.low_latency;
+    j["latency_report"] = default_config.latency_report;
+    j["stats_file"] = default_config.stats_file;
+    j["budget"] = {
+        {"max_effects", default_config.budget.max_effects},
+        {"coalesce_window", default_config.budget.coalesce_window},
+        {"max_intensity", default_config.budget.max_intensity},
+        {"target_frame_ms", default_config.budget.target_frame_ms}
+    };
+    j["placement"] = {
+        {"cell_size", default_config.placement.cell_size},
+        {"max_overdraw", default_config.placement.max_overdraw},
+        {"bias", "none"}
+    };
+    j["capture"] = {
+        {"enabled", default_config.capture.enabled},
+        {"path", default_config.capture.path},
+        {"format", "y4m"},
+        {"buffers", default_config.capture.buffers},
+        {"queue", default_config.capture.queue}
+    };
+    j["control"] = {
+        {"enabled", default_config.control.enabled},
+        {"pipe", default_config.control.pipe}
+    };
+    j["streaming"] = {
+        {"threshold_kb", default_config.streaming.threshold_kb},
+        {"head_ms", default_config.streaming.head_ms},
+        {"memory_kb", default_config.streaming.memory_kb},
+        {"max_voices", default_config.streaming.max_voices}
+    };
+    j["monitors"] = "primary";
+    j["effect_routing"] = "focused";
+    
+    j["curves"] = {
+        {"default", {
+            {"duration", default_config.default_curve.duration},
+            {"alpha", {{0, 1}, {1, 0}}},
+            {"scale", {{0, 1}, {1, 1.5}}}
+        }}
+    };
+    
+    j["emitters"] = json::array();
+    for (const auto& emitter : default_config.emitters) {
+        j["emitters"].push_back(emitter_config_to_json(emitter));
+    }
+    
+    j["bindings"] = json::array();
+    for (const auto& binding : default_config.bindings) {
+        j["bindings"].push_back(binding_config_to_json(binding));
+    }
     
     std::ofstream config_file(filename);
     if (config_file.is_open()) {
@@ -143,13 +482,26 @@ Config load_config(const std::string& filename)
         }
         
         if (j.contains("main_sound")) {
-            config.main_sound = j["main_sound"].get<std::string>();
-            LOG_INFO("Loaded main_sound: " << config.main_sound);
+            if (j["main_sound"].is_object()) {
+                config.main_synth = true;
+                config.main_synth_params = parse_synth_params(j["main_sound"]);
+                LOG_INFO("Loaded main_sound: synth");
+            } else {
+                config.main_sound = j["main_sound"].get<std::string>();
+                LOG_INFO("Loaded main_sound: " << config.main_sound);
+            }
         }
         
         if (j.contains("per_key_overrides") && j["per_key_overrides"].is_object()) {
-            config.per_key_overrides = j["per_key_overrides"].get<std::map<std::string, std::string>>();
-            LOG_INFO("Loaded " << config.per_key_overrides.size() << " per-key overrides");
+            config.per_key_overrides.clear();
+            for (const auto& [key_name, value] : j["per_key_overrides"].items()) {
+                if (value.is_object()) {
+                    config.synth_overrides[key_name] = parse_synth_params(value);
+                } else {
+                    config.per_key_overrides[key_name] = value.get<std::string>();
+                }
+            }
+            LOG_INFO("Loaded " << config.per_key_overrides.size() + config.synth_overrides.size() << " per-key overrides");
         }
         
         if (j.contains("images") && j["images"].is_array()) {
@@ -163,12 +515,198 @@ Config load_config(const std::string& filename)
                 LOG_INFO("Loaded font: " << config.font);
             }
         }
+        
+        if (j.contains("fallback_fonts") && j["fallback_fonts"].is_array()) {
+            config.fallback_fonts = j["fallback_fonts"].get<std::vector<std::string>>();
+            LOG_INFO("Loaded " << config.fallback_fonts.size() << " fallback fonts");
+        }
+        config.glyph_size = j.value("glyph_size", config.glyph_size);
 
         if (j.contains("colorize")) {
-            config.colorize = j["colorize"].get<std::string>();
+            if (j["colorize"].is_object()) {
+                const json& colorize = j["colorize"];
+                
+                if (colorize.contains("colors") && colorize["colors"].is_array() && !colorize["colors"].empty()) {
+                    config.colorize = colorize["colors"][0].get<std::string>();
+                    if (colorize["colors"].size() > 1) {
+                        config.colorize_config.gradient = parse_hex_color(colorize["colors"][1].get<std::string>());
+                        config.colorize_config.use_gradient = true;
+                    }
+                }
+                
+                config.colorize_config.hue_cycle = colorize.value("hue_cycle", 0.0f);
+                
+                if (colorize.contains("per_key") && colorize["per_key"].is_object()) {
+                    for (const auto& [key_name, color] : colorize["per_key"].items()) {
+                        config.colorize_config.per_key[key_name] = parse_hex_color(color.get<std::string>());
+                    }
+                }
+            } else {
+                config.colorize = j["colorize"].get<std::string>();
+            }
             LOG_INFO("Loaded colorize: " << config.colorize);
         }
         
+        if (j.contains("simulation_rate")) {
+            config.simulation_rate = j["simulation_rate"].get<int>();
+            if (config.simulation_rate < 1) config.simulation_rate = 1;
+            if (config.simulation_rate > 1000) config.simulation_rate = 1000;
+            LOG_INFO("Loaded simulation_rate: " << config.simulation_rate << " Hz");
+        }
+        
+        if (j.contains("image_size")) {
+            config.texture_options.size = j["image_size"].get<int>();
+            LOG_INFO("Loaded image_size: " << config.texture_options.size);
+        }
+        
+        if (j.contains("texture_storage")) {
+            std::string storage = j["texture_storage"].get<std::string>();
+            if (storage == "dxt") {
+                config.texture_options.storage = TextureStorage::DXT;
+            } else if (storage == "palette") {
+                config.texture_options.storage = TextureStorage::PALETTE;
+            } else {
+                config.texture_options.storage = TextureStorage::RGBA;
+            }
+            LOG_INFO("Loaded texture_storage: " << storage);
+        }
+        
+        if (j.contains("input_thread")) {
+            config.input_thread = j["input_thread"].get<bool>();
+            LOG_INFO("Loaded input_thread: " << (config.input_thread ? "true" : "false"));
+        }
+        
+        if (j.contains("low_latency")) {
+            config.low_latency = j["low_latency"].get<bool>();
+            LOG_INFO("Loaded low_latency: " << (config.low_latency ? "true" : "false"));
+        }
+        
+        if (j.contains("stats_file")) {
+            config.stats_file = j["stats_file"].get<std::string>();
+            LOG_INFO("Loaded stats_file: " << config.stats_file);
+        }
+        
+        if (j.contains("latency_report")) {
+            config.latency_report = j["latency_report"].get<bool>();
+        }
+        
+        if (j.contains("budget") && j["budget"].is_object()) {
+            const json& budget = j["budget"];
+            config.budget.max_effects = budget.value("max_effects", config.budget.max_effects);
+            config.budget.coalesce_window = budget.value("coalesce_window", config.budget.coalesce_window);
+            config.budget.max_intensity = budget.value("max_intensity", config.budget.max_intensity);
+            config.budget.target_frame_ms = budget.value("target_frame_ms", config.budget.target_frame_ms);
+            LOG_INFO("Loaded budget: " << config.budget.max_effects << " effects max");
+        }
+        
+        if (j.contains("placement") && j["placement"].is_object()) {
+            const json& placement = j["placement"];
+            config.placement.cell_size = placement.value("cell_size", config.placement.cell_size);
+            config.placement.max_overdraw = placement.value("max_overdraw", config.placement.max_overdraw);
+            
+            std::string bias = placement.value("bias", std::string("none"));
+            if (bias == "caret") {
+                config.placement.bias = PlacementBias::CARET;
+            } else if (bias == "region") {
+                config.placement.bias = PlacementBias::REGION;
+            } else {
+                config.placement.bias = PlacementBias::NONE;
+            }
+            
+            if (placement.contains("region") && placement["region"].is_array() && placement["region"].size() == 4) {
+                for (int i = 0; i < 4; i++) {
+                    config.placement.region[i] = placement["region"][i].get<float>();
+                }
+            }
+            LOG_INFO("Loaded placement: " << config.placement.cell_size << " px cells, bias " << bias);
+        }
+        
+        if (j.contains("capture") && j["capture"].is_object()) {
+            const json& capture = j["capture"];
+            config.capture.enabled = capture.value("enabled", config.capture.enabled);
+            config.capture.path = capture.value("path", config.capture.path);
+            config.capture.buffers = capture.value("buffers", config.capture.buffers);
+            config.capture.queue = capture.value("queue", config.capture.queue);
+            
+            std::string format = capture.value("format", std::string("y4m"));
+            if (format == "raw") {
+                config.capture.format = CaptureFormat::RAW;
+            } else if (format == "png") {
+                config.capture.format = CaptureFormat::PNG;
+            } else {
+                config.capture.format = CaptureFormat::Y4M;
+            }
+            LOG_INFO("Loaded capture: " << format << " to " << config.capture.path);
+        }
+        
+        if (j.contains("control") && j["control"].is_object()) {
+            const json& control = j["control"];
+            config.control.enabled = control.value("enabled", config.control.enabled);
+            config.control.pipe = control.value("pipe", config.control.pipe);
+            LOG_INFO("Loaded control: " << (config.control.enabled ? "on " : "off ") << ControlServer::pipe_path(config.control.pipe));
+        }
+        
+        if (j.contains("streaming") && j["streaming"].is_object()) {
+            const json& streaming = j["streaming"];
+            // read wide so a huge value clamps instead of wrapping
+            config.streaming.threshold_kb = (int)std::clamp(streaming.value("threshold_kb", (int64_t)config.streaming.threshold_kb),
+                                                            (int64_t)0, (int64_t)StreamingConfig::MAX_KB);
+            config.streaming.head_ms = streaming.value("head_ms", config.streaming.head_ms);
+            config.streaming.memory_kb = (int)std::clamp(streaming.value("memory_kb", (int64_t)config.streaming.memory_kb),
+                                                         (int64_t)0, (int64_t)StreamingConfig::MAX_KB);
+            config.streaming.max_voices = streaming.value("max_voices", config.streaming.max_voices);
+            LOG_INFO("Loaded streaming: files over " << config.streaming.threshold_kb << " KB, " << config.streaming.memory_kb << " KB budget");
+        }
+        
+        if (j.contains("monitors")) {
+            if (j["monitors"].is_array()) {
+                config.monitors = j["monitors"].get<std::vector<int>>();
+                LOG_INFO("Loaded " << config.monitors.size() << " monitors");
+            } else if (j["monitors"].is_string()) {
+                std::string monitors = j["monitors"].get<std::string>();
+                if (monitors == "all") {
+                    config.monitors.clear();
+                } else {
+                    config.monitors = {0};
+                }
+                LOG_INFO("Loaded monitors: " << monitors);
+            }
+        }
+        
+        if (j.contains("effect_routing")) {
+            config.route_to_all_monitors = j["effect_routing"].get<std::string>() == "all";
+            LOG_INFO("Loaded effect_routing: " << (config.route_to_all_monitors ? "all" : "focused"));
+        }
+        
+        if (j.contains("emitters") && j["emitters"].is_array()) {
+            config.emitters.clear();
+            for (const auto& emitter : j["emitters"]) {
+                config.emitters.push_back(parse_emitter_config(emitter));
+            }
+            LOG_INFO("Loaded " << config.emitters.size() << " particle emitters");
+        }
+        
+        if (j.contains("curves") && j["curves"].is_object()) {
+            const json& curves = j["curves"];
+            if (curves.contains("default") && curves["default"].is_object()) {
+                config.default_curve = parse_curve_spec(curves["default"], config.default_curve);
+            }
+            for (const auto& [key_name, curve] : curves.items()) {
+                if (key_name != "default" && curve.is_object()) {
+                    config.key_curves[key_name] = parse_curve_spec(curve, config.default_curve);
+                }
+            }
+            LOG_INFO("Loaded " << config.key_curves.size() + 1 << " effect curves");
+        }
+        
+        if (j.contains("bindings") && j["bindings"].is_array()) {
+            config.bindings.clear();
+            for (const auto& binding : j["bindings"]) {
+                config.bindings.push_back(parse_binding_config(binding));
+            }
+            LOG_INFO("Loaded " << config.bindings.size() << " bindings");
+        }
+        
     } catch (const json::exception& e) {
         LOG_ERROR("Failed to parse config file: " << e.what());
         LOG_INFO("Using default configuration");
@@ -207,8 +745,16 @@ std::string vk_code_to_key_name(int vk_code)
         case VK_MEDIA_PREV_TRACK: return "prevtrack";
         case VK_MEDIA_STOP: return "stop";
         case VK_MEDIA_PLAY_PAUSE: return "playpause";
+        case VK_LEFT: return "left";
+        case VK_UP: return "up";
+        case VK_RIGHT: return "right";
+        case VK_DOWN: return "down";
 
         default: {
+            if (vk_code >= VK_F1 && vk_code <= VK_F24) {
+                return "f" + std::to_string(vk_code - VK_F1 + 1);
+            }
+            
             char key_char = MapVirtualKeyA(vk_code, MAPVK_VK_TO_CHAR);
             if (key_char >= 32 && key_char <= 126) {
                 return std::string(1, std::tolower(key_char));
@@ -223,26 +769,282 @@ static void enqueue_tone_for_key(int key)
     // check if there's per key override
     std::string key_name = vk_code_to_key_name(key);
     Sound* sound_to_play = &g_main_sound;
+    StreamedSound* stream_to_play = g_main_stream;
+    int synth_to_play = g_main_synth;
     
     if (!key_name.empty()) {
         auto it = g_key_sounds.find(key_name);
         if (it != g_key_sounds.end() && it->second.frameCount > 0) {
             sound_to_play = &it->second;
+            stream_to_play = nullptr;
+            synth_to_play = -1;
+        }
+        
+        auto stream = g_key_streams.find(key_name);
+        if (stream != g_key_streams.end()) {
+            stream_to_play = stream->second;
+            synth_to_play = -1;
+        }
+        
+        auto synth = g_key_synths.find(key_name);
+        if (synth != g_key_synths.end()) {
+            synth_to_play = synth->second;
         }
     }
     
-    if (sound_to_play->frameCount > 0) {
+    if (synth_to_play >= 0) {
+        g_synth.trigger(synth_to_play, g_volume);
+    } else if (stream_to_play) {
+        g_streamer.play(stream_to_play, g_volume);
+    } else if (sound_to_play->frameCount > 0) {
         SetSoundVolume(*sound_to_play, g_volume);
         PlaySound(*sound_to_play);
     }
 }
 
+static std::map<std::string, int> build_key_name_map()
+{
+    std::map<std::string, int> names;
+    for (int vk = 1; vk < 255; vk++) {
+        std::string name = vk_code_to_key_name(vk);
+        if (!name.empty() && names.find(name) == names.end()) {
+            names[name] = vk;
+        }
+    }
+    return names;
+}
+
+static int binding_modifier(const std::string& name)
+{
+    if (name == "ctrl" || name == "control") return TriggerEngine::CTRL;
+    if (name == "alt") return TriggerEngine::ALT;
+    if (name == "shift") return TriggerEngine::SHIFT;
+    if (name == "win") return TriggerEngine::WIN;
+    return 0;
+}
+
+// "ctrl+alt+f", modifiers plus exactly one other key
+static bool parse_chord_keys(const std::string& text, const std::map<std::string, int>& names, int& modifiers, int& vk)
+{
+    modifiers = 0;
+    vk = 0;
+    
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('+', start);
+        if (end == std::string::npos) end = text.size();
+        std::string token = text.substr(start, end - start);
+        start = end + 1;
+        
+        if (int modifier = binding_modifier(token)) {
+            modifiers |= modifier;
+            continue;
+        }
+        
+        auto it = names.find(token);
+        if (it == names.end() || vk != 0) {
+            return false;
+        }
+        vk = it->second;
+    }
+    
+    return vk != 0;
+}
+
+// "up up down down", or "gg" when every character is a key of its own
+static bool parse_sequence_keys(const std::string& text, const std::map<std::string, int>& names, std::vector<int>& keys)
+{
+    std::istringstream tokens(text);
+    std::string token;
+    while (tokens >> token) {
+        auto it = names.find(token);
+        if (it != names.end()) {
+            keys.push_back(it->second);
+            continue;
+        }
+        
+        for (char c : token) {
+            auto key = names.find(std::string(1, (char)std::tolower(c)));
+            if (key == names.end()) {
+                return false;
+            }
+            keys.push_back(key->second);
+        }
+    }
+    
+    return !keys.empty();
+}
+
+static void compile_bindings(std::vector<BindingConfig> bindings)
+{
+    // never lose the way out
+    bool has_exit = false;
+    for (const auto& binding : bindings) {
+        has_exit |= binding.action == "exit";
+    }
+    if (!has_exit) {
+        bindings.push_back(Config().bindings.front());
+    }
+    
+    std::map<std::string, int> names = build_key_name_map();
+    
+    for (const auto& binding : bindings) {
+        BindingAction action;
+        action.exit = binding.action == "exit";
+        action.capture = binding.action == "capture";
+        action.text = binding.text;
+        
+        int index = (int)g_binding_actions.size();
+        if (!binding.chord.empty()) {
+            int modifiers, vk;
+            if (!parse_chord_keys(binding.chord, names, modifiers, vk)) {
+                LOG_WARNING("Invalid chord binding: " << binding.chord);
+                continue;
+            }
+            if (!g_triggers.add_chord(modifiers, vk, index)) {
+                LOG_WARNING("Chord '" << binding.chord << "' is bound more than once, the last one wins");
+            }
+            action.chord = true;
+        } else if (!binding.sequence.empty()) {
+            std::vector<int> keys;
+            if (!parse_sequence_keys(binding.sequence, names, keys)) {
+                LOG_WARNING("Invalid sequence binding: " << binding.sequence);
+                continue;
+            }
+            g_triggers.add_sequence(keys, index);
+        } else {
+            LOG_WARNING("Binding without a chord or sequence ignored");
+            continue;
+        }
+        
+        if (!binding.sound.empty()) {
+            action.sound = g_samples.load(binding.sound);
+            if (action.sound.frameCount == 0) {
+                LOG_WARNING("Failed to load binding sound: " << binding.sound);
+            }
+        }
+        if (binding.synth) {
+            action.synth = g_synth.add_preset(binding.synth_params);
+        }
+        
+        g_binding_actions.push_back(action);
+    }
+    
+    g_triggers.set_modifier_probe([](int vk) { return (GetAsyncKeyState(vk) & 0x8000) != 0; });
+    g_triggers.compile();
+    LOG_INFO("Compiled " << g_binding_actions.size() << " bindings, " << g_triggers.get_state_count() << " sequence states");
+}
+
+// what the key types in the focused window's keyboard layout, empty for keys
+// that don't produce a printable character
+static std::string key_to_utf8(DWORD vkCode, DWORD scanCode)
+{
+    BYTE key_state[256] = {};
+    int modifiers = g_triggers.modifiers();
+    if (modifiers & TriggerEngine::SHIFT) key_state[VK_SHIFT] = 0x80;
+    if (modifiers & TriggerEngine::CTRL) key_state[VK_CONTROL] = 0x80;
+    if (modifiers & TriggerEngine::ALT) key_state[VK_MENU] = 0x80;
+    if (GetKeyState(VK_CAPITAL) & 1) key_state[VK_CAPITAL] = 0x01;
+    
+    HKL layout = GetKeyboardLayout(GetWindowThreadProcessId(GetForegroundWindow(), nullptr));
+    
+    // flag 0x4 keeps the call from touching the dead key state of the app being typed into
+    wchar_t buffer[8];
+    int count = ToUnicodeEx(vkCode, scanCode, key_state, buffer, 8, 0x4, layout);
+    if (count < 0) {
+        // dead key, the buffer holds its spacing form
+        count = 1;
+    }
+    
+    std::string text;
+    for (int i = 0; i < count; i++) {
+        unsigned int codepoint = buffer[i];
+        if (codepoint >= 0xD800 && codepoint <= 0xDBFF && i + 1 < count && buffer[i + 1] >= 0xDC00 && buffer[i + 1] <= 0xDFFF) {
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (buffer[++i] - 0xDC00);
+        }
+        // a lone surrogate has no utf-8 form
+        if (codepoint < 32 || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) continue;
+        
+        if (codepoint < 0x80) {
+            text += (char)codepoint;
+        } else if (codepoint < 0x800) {
+            text += (char)(0xC0 | (codepoint >> 6));
+            text += (char)(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            text += (char)(0xE0 | (codepoint >> 12));
+            text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            text += (char)(0x80 | (codepoint & 0x3F));
+        } else {
+            text += (char)(0xF0 | (codepoint >> 18));
+            text += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            text += (char)(0x80 | (codepoint & 0x3F));
+        }
+    }
+    return text;
+}
+
+// null unless placement leans towards the caret and the focused app has one
+static const float* effect_caret(float point[2])
+{
+    if (!g_place_near_caret || !query_caret_position(g_output_bounds, point)) {
+        return nullptr;
+    }
+    return point;
+}
+
+static int effect_output()
+{
+    if (g_route_to_all_monitors) {
+        return -1;
+    }
+    
+    int output = query_focused_output(g_outputs, g_output_bounds);
+    return output < 0 ? 0 : output;
+}
+
+// returns true when a chord took over the press
+static bool run_bindings(DWORD vkCode)
+{
+    bool consumed = false;
+    
+    for (int index : g_triggers.key_down(vkCode)) {
+        const BindingAction& action = g_binding_actions[index];
+        if (action.exit) {
+            g_running = false;
+            return true;
+        }
+        if (action.capture) {
+            g_capture_toggle = true;
+        }
+        
+        if (action.synth >= 0) {
+            g_synth.trigger(action.synth, g_volume);
+        } else if (action.sound.frameCount > 0) {
+            SetSoundVolume(action.sound, g_volume);
+            PlaySound(action.sound);
+        }
+        
+        if (!action.text.empty() && g_renderer) {
+            float caret[2];
+            g_renderer->add_key_effect(action.text, vkCode, effect_output(), effect_caret(caret));
+        }
+        
+        consumed |= action.chord;
+    }
+    
+    return consumed;
+}
+
 LRESULT __stdcall keyboard_hook_proc(int nCode, WPARAM wParam, LPARAM lParam)
 {
     if (nCode == HC_ACTION) {
         KBDLLHOOKSTRUCT* kbd = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
         DWORD vkCode = kbd->vkCode;
         
+        // event timestamp to dispatch, only as fine as the system tick
+        g_hook_latency.record_us((uint64_t)(DWORD)(GetTickCount() - kbd->time) * 1000);
+        
         if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN) {
             if (kbd->flags & LLKHF_UP) {
                 return CallNextHookEx(g_keyboard_hook, nCode, wParam, lParam);
@@ -250,20 +1052,16 @@ LRESULT __stdcall keyboard_hook_proc(int nCode, WPARAM wParam, LPARAM lParam)
             
             std::lock_guard<std::mutex> lk(g_keys_mutex);
             
-            // exit key combo (ctrl+alt+f)
-            if (vkCode == 'F') {
-                bool ctrl_pressed = (GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0;
-                bool alt_pressed = (GetAsyncKeyState(VK_MENU) & 0x8000) != 0;
-                
-                if (ctrl_pressed && alt_pressed) {
-                    g_running = false;
-                    return CallNextHookEx(g_keyboard_hook, nCode, wParam, lParam);
-                }
-            }
-            
             // play once per key press
             if (g_pressed_keys.find(vkCode) == g_pressed_keys.end()) {
                 g_pressed_keys.insert(vkCode);
+                g_stats.record_press(vkCode, kbd->time);
+                
+                // chords and sequences, including the exit combo
+                if (run_bindings(vkCode)) {
+                    return CallNextHookEx(g_keyboard_hook, nCode, wParam, lParam);
+                }
+                
                 enqueue_tone_for_key(vkCode);
                 
                 LOG_INFO("Key pressed: vkCode=" << vkCode << " (first press)");
@@ -327,6 +1125,8 @@ LRESULT __stdcall keyboard_hook_proc(int nCode, WPARAM wParam, LPARAM lParam)
                         key_text = "PLAY";
                     } else if (vkCode >= VK_F1 && vkCode <= VK_F12) {
                         key_text = "F" + std::to_string(vkCode - VK_F1 + 1);
+                    } else if (std::string typed = key_to_utf8(vkCode, kbd->scanCode); !typed.empty()) {
+                        key_text = typed;
                     } else {
                         char key_char = MapVirtualKeyA(vkCode, MAPVK_VK_TO_CHAR);
                         if (key_char != 0) {
@@ -336,7 +1136,8 @@ LRESULT __stdcall keyboard_hook_proc(int nCode, WPARAM wParam, LPARAM lParam)
                         }
                     }
                     
-                    g_renderer->add_key_effect(key_text, vkCode);
+                    float caret[2];
+                    g_renderer->add_key_effect(key_text, vkCode, effect_output(), effect_caret(caret));
                     LOG_INFO("Added visual effect for key: " << key_text);
                 }
             } else {
@@ -345,14 +1146,265 @@ LRESULT __stdcall keyboard_hook_proc(int nCode, WPARAM wParam, LPARAM lParam)
         } else if (wParam == WM_KEYUP || wParam == WM_SYSKEYUP) {
             std::lock_guard<std::mutex> lk(g_keys_mutex);
             g_pressed_keys.erase(vkCode);
+            g_triggers.key_up(vkCode);
         }
     }
     return CallNextHookEx(g_keyboard_hook, nCode, wParam, lParam);
 }
 
-int main()
+// the hook is dispatched through the installing thread's message loop, so this
+// thread does nothing else and never waits on the renderer's vsync
+static void run_input_thread(std::promise<bool> installed)
+{
+    g_input_thread_id = GetCurrentThreadId();
+    g_keyboard_hook = SetWindowsHookEx(WH_KEYBOARD_LL, keyboard_hook_proc, GetModuleHandle(NULL), 0);
+    installed.set_value(g_keyboard_hook != nullptr);
+    
+    if (!g_keyboard_hook) {
+        return;
+    }
+    
+    MSG msg;
+    while (GetMessageA(&msg, nullptr, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessageA(&msg);
+    }
+    
+    UnhookWindowsHookEx(g_keyboard_hook);
+    g_keyboard_hook = nullptr;
+}
+
+static bool install_keyboard_hook(bool own_thread)
+{
+    if (!own_thread) {
+        g_keyboard_hook = SetWindowsHookEx(WH_KEYBOARD_LL, keyboard_hook_proc, GetModuleHandle(NULL), 0);
+        return g_keyboard_hook != nullptr;
+    }
+    
+    std::promise<bool> installed;
+    std::future<bool> result = installed.get_future();
+    g_input_thread = std::thread(run_input_thread, std::move(installed));
+    
+    if (!result.get()) {
+        g_input_thread.join();
+        return false;
+    }
+    return true;
+}
+
+static void remove_keyboard_hook()
+{
+    if (g_input_thread.joinable()) {
+        PostThreadMessageA(g_input_thread_id, WM_QUIT, 0, 0);
+        g_input_thread.join();
+    } else if (g_keyboard_hook) {
+        UnhookWindowsHookEx(g_keyboard_hook);
+        g_keyboard_hook = nullptr;
+    }
+}
+
+// render thread, follows capture_config.enabled
+static void start_or_stop_capture(OverlayCapture& capture, const CaptureConfig& capture_config, int fps)
+{
+    if (capture_config.enabled && !capture.is_running()) {
+        if (capture.start(capture_config, GetRenderWidth(), GetRenderHeight(), fps)) {
+            LOG_INFO("Capturing overlay to " << capture.get_output_path() << " (" << GetRenderWidth() << "x" << GetRenderHeight()
+                     << " @ " << fps << " fps)");
+        } else {
+            LOG_ERROR("Failed to start overlay capture to " << capture_config.path);
+        }
+    } else if (!capture_config.enabled && capture.is_running()) {
+        capture.stop();
+        LOG_INFO("Capture stopped: " << capture.get_frames() << " frames, " << capture.get_written() << " written, "
+                 << capture.get_dropped() << " dropped");
+        LOG_INFO("Capture readback latency: " << capture.get_readback_latency().summary());
+    }
+}
+
+static LatencySummary summarize_latency(const LatencyHistogram& histogram)
+{
+    return {histogram.get_average_us(), histogram.percentile_us(0.99), histogram.get_max_us(), histogram.get_count()};
+}
+
+static json latency_to_json(const LatencySummary& latency)
+{
+    return {
+        {"samples", latency.count},
+        {"avg_us", (uint64_t)latency.average_us},
+        {"p99_us", latency.p99_us},
+        {"max_us", latency.max_us}
+    };
+}
+
+// control thread, never touches the renderer or the audio objects directly
+static std::string handle_control_request(const std::string& line)
+{
+    json request = json::parse(line, nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        return json({{"ok", false}, {"error", "requests are json objects"}}).dump();
+    }
+    
+    std::string command = request.value("command", std::string());
+    json reply = {{"ok", true}, {"command", command}};
+    
+    if (command == "stats") {
+        g_overlay_stats.acquire();
+        const OverlayStats& stats = g_overlay_stats.read_buffer();
+        reply["stats"] = {
+            {"frames", stats.frames},
+            {"frame_ms", {{"last", stats.frame_ms}, {"avg", stats.frame_average_ms}, {"max", stats.frame_max_ms}}},
+            {"quality", {{"level", stats.quality_level}, {"drops", stats.quality_drops}}},
+            {"effects", stats.effects},
+            {"simulation", {{"ticks", stats.ticks}, {"avg_step_us", stats.step_us}, {"coalesced", stats.coalesced}, {"shed", stats.shed}}},
+            {"latency", {{"spawn_to_present", latency_to_json(stats.present_latency)}, {"hook", latency_to_json(stats.hook_latency)}}},
+            {"audio", {
+                {"volume", (int)std::lround(g_volume.load() * 100.0f)},
+                {"synth_voices", stats.synth_voices},
+                {"stream_voices_playing", stats.stream_voices_playing},
+                {"stream_voices", stats.stream_voices},
+                {"stream_steals", stats.stream_steals},
+                {"stream_drops", stats.stream_drops}
+            }},
+            {"memory_bytes", {{"textures", stats.texture_bytes}, {"samples", stats.sample_bytes}, {"streams", stats.stream_bytes}}},
+            {"colorize", color_to_hex(g_control_colorize.color)}
+        };
+    } else if (command == "volume") {
+        if (!request.contains("value") || !request["value"].is_number()) {
+            return json({{"ok", false}, {"error", "volume needs a numeric value in percent"}}).dump();
+        }
+        // same range as the config, presses after this play at the new volume
+        float volume_percent = std::clamp(request["value"].get<float>(), 0.0f, 500.0f);
+        g_volume = volume_percent / 100.0f;
+        reply["volume"] = volume_percent;
+    } else if (command == "colorize") {
+        ColorizeConfig& colorize = g_colorize_requests.write_buffer();
+        colorize = g_control_colorize;
+        if (request.contains("color") && request["color"].is_string()) {
+            colorize.color = parse_hex_color(request["color"].get<std::string>());
+        }
+        if (request.contains("gradient") && request["gradient"].is_string()) {
+            std::string gradient = request["gradient"].get<std::string>();
+            colorize.use_gradient = !gradient.empty();
+            if (colorize.use_gradient) {
+                colorize.gradient = parse_hex_color(gradient);
+            }
+        }
+        if (request.contains("hue_cycle") && request["hue_cycle"].is_number()) {
+            colorize.hue_cycle = request["hue_cycle"].get<float>();
+        }
+        g_control_colorize = colorize;
+        g_colorize_requests.publish();
+        reply["color"] = color_to_hex(colorize.color);
+    } else if (command == "reset") {
+        g_reset_counters = true;
+    } else {
+        return json({{"ok", false}, {"error", "unknown command '" + command + "'"}}).dump();
+    }
+    
+    return reply.dump();
+}
+
+// render thread, once a frame while the control endpoint runs
+static void publish_overlay_stats(uint64_t frames, float frame_ms, double frame_total_ms, float frame_max_ms)
+{
+    OverlayStats& stats = g_overlay_stats.write_buffer();
+    stats.frames = frames;
+    stats.frame_ms = frame_ms;
+    stats.frame_average_ms = frames > 0 ? (float)(frame_total_ms / frames) : 0.0f;
+    stats.frame_max_ms = frame_max_ms;
+    
+    const EffectSimulation& simulation = g_renderer->get_simulation();
+    stats.quality_level = g_renderer->get_quality().get_level();
+    stats.quality_drops = g_renderer->get_quality().get_degrade_count();
+    stats.effects = g_renderer->get_effect_count();
+    stats.ticks = simulation.get_tick_count();
+    stats.step_us = simulation.get_average_step_us();
+    stats.coalesced = simulation.get_coalesced_count();
+    stats.shed = simulation.get_shed_count();
+    stats.present_latency = summarize_latency(g_renderer->get_present_latency());
+    stats.hook_latency = summarize_latency(g_hook_latency);
+    
+    stats.synth_voices = g_synth.get_active_voices();
+    stats.stream_voices_playing = g_streamer.get_playing_count();
+    stats.stream_voices = g_streamer.get_voice_count();
+    stats.stream_steals = g_streamer.get_steal_count();
+    stats.stream_drops = g_streamer.get_drop_count();
+    
+    stats.texture_bytes = g_renderer->get_texture_bytes();
+    stats.sample_bytes = g_samples.get_stats().stored_bytes;
+    stats.stream_bytes = g_streamer.get_memory_bytes();
+    g_overlay_stats.publish();
+}
+
+// funny-keyboard --control <command> [value] talks to a running overlay,
+// a command starting with { is sent as is
+static int send_control_request(const ControlConfig& control, int argc, char** argv)
+{
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+    }
+    
+    std::string command = argc > 2 ? argv[2] : "stats";
+    std::string value = argc > 3 ? argv[3] : "";
+    
+    json request;
+    if (!command.empty() && command[0] == '{') {
+        request = json::parse(command, nullptr, false);
+    } else if (command == "volume") {
+        request = {{"command", command}, {"value", std::atof(value.c_str())}};
+    } else if (command == "colorize") {
+        request = {{"command", command}, {"color", value}};
+    } else {
+        request = {{"command", command}};
+    }
+    if (request.is_discarded()) {
+        std::cout << "Not a json request: " << command << "\n";
+        return 1;
+    }
+    
+    std::string reply;
+    if (!ControlServer::request(control.pipe, request.dump(), reply)) {
+        std::cout << "No overlay listening on " << ControlServer::pipe_path(control.pipe)
+                  << " (set \"control\": {\"enabled\": true} in config.json)\n";
+        return 1;
+    }
+    
+    json parsed = json::parse(reply, nullptr, false);
+    std::cout << (parsed.is_discarded() ? reply : parsed.dump(4)) << "\n";
+    std::cout.flush();
+    return !parsed.is_discarded() && parsed.value("ok", false) ? 0 : 1;
+}
+
+// funny-keyboard --stats [file] prints the saved typing statistics
+static int dump_stats(const std::string& path)
+{
+    // release builds have no console of their own
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+    }
+    
+    TypingStats stats;
+    if (!stats.open(path, true)) {
+        std::cout << "No typing statistics in '" << path << "'\n";
+        return 1;
+    }
+    
+    stats.dump(std::cout, vk_code_to_key_name);
+    std::cout.flush();
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
     Config config = load_config("config.json");
+    
+    if (argc > 1 && std::string(argv[1]) == "--stats") {
+        return dump_stats(argc > 2 ? argv[2] : config.stats_file);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--control") {
+        return send_control_request(config.control, argc, argv);
+    }
+    
     g_volume = config.volume;
     int monitor_width = GetScreenWidth();
     int monitor_height = GetScreenHeight();
@@ -368,8 +1420,32 @@ int main()
                     FLAG_WINDOW_TOPMOST | FLAG_WINDOW_MOUSE_PASSTHROUGH);
     
     InitWindow(monitor_width, monitor_height, "funny-keyboard");
-    SetWindowPosition(0, 0);
-    SetTargetFPS(60);
+    
+    // grow the overlay over every selected monitor
+    g_outputs = query_outputs(config.monitors, g_output_bounds);
+    g_route_to_all_monitors = config.route_to_all_monitors;
+    
+    int target_fps = 60;
+    if (!g_outputs.empty()) {
+        monitor_width = g_output_bounds.width;
+        monitor_height = g_output_bounds.height;
+        SetWindowSize(monitor_width, monitor_height);
+        SetWindowPosition(g_output_bounds.x, g_output_bounds.y);
+        
+        // present at the fastest selected display's rate
+        for (const auto& output : g_outputs) {
+            LOG_INFO("Monitor " << output.monitor << ": " << output.width << "x" << output.height
+                     << " @ " << output.refresh_rate << " Hz, dpi scale " << output.dpi_scale);
+            if (output.refresh_rate > target_fps) {
+                target_fps = output.refresh_rate;
+            }
+        }
+    } else {
+        LOG_WARNING("No configured monitor found, using the primary monitor");
+        SetWindowPosition(0, 0);
+    }
+    // low latency mode paces frames itself instead of raylib's limiter
+    SetTargetFPS(config.low_latency ? 0 : target_fps);
     
     HWND hwnd = (HWND)GetWindowHandle();
     
@@ -407,12 +1483,65 @@ int main()
     ShowWindow(hwnd, SW_SHOWNOACTIVATE);
     
     g_renderer = new KeyRenderer(monitor_width, monitor_height);
+    g_renderer->set_placement(config.placement);
+    g_renderer->set_outputs(g_outputs);
+    g_place_near_caret = config.placement.bias == PlacementBias::CARET;
+    
+    // a quarter frame of slack before quality starts dropping
+    float target_frame_ms = config.budget.target_frame_ms;
+    if (target_frame_ms <= 0.0f) {
+        target_frame_ms = 1000.0f / target_fps * 1.25f;
+    }
+    g_renderer->set_frame_time_target(target_frame_ms);
+    g_renderer->set_late_latch(config.low_latency);
+    g_renderer->set_glyph_fonts(config.fallback_fonts, config.glyph_size);
+    
+    // curves are looked up by vk at spawn, resolve the key names once here
+    std::vector<EffectCurve> curves = {EffectCurve(config.default_curve)};
+    std::vector<int> key_curves(256, 0);
+    std::map<std::string, int> curve_indices;
+    for (int vk = 1; vk < 255; vk++) {
+        auto spec = config.key_curves.find(vk_code_to_key_name(vk));
+        if (spec == config.key_curves.end()) continue;
+        
+        auto [index, added] = curve_indices.try_emplace(spec->first, (int)curves.size());
+        if (added) {
+            curves.emplace_back(spec->second);
+        }
+        key_curves[vk] = index->second;
+    }
+    for (const auto& [key_name, spec] : config.key_curves) {
+        if (curve_indices.find(key_name) == curve_indices.end()) {
+            LOG_WARNING("Unknown key in curves: " << key_name);
+        }
+    }
+    g_renderer->set_curves(std::move(curves), key_curves);
     Color tint_color = parse_hex_color(config.colorize);
-    if (!g_renderer->init(config.images, config.font, tint_color)) {
+    if (!g_renderer->init(config.images, config.font, tint_color, config.emitters, config.simulation_rate, config.budget,
+                          config.texture_options)) {
         LOG_ERROR("Failed to initialize renderer");
         CloseWindow();
         return 1;
     }
+    
+    // per key colors are looked up by vk at spawn, like the curves
+    ColorizeConfig colorize_config = config.colorize_config;
+    colorize_config.color = tint_color;
+    std::map<int, Color> key_colors;
+    for (int vk = 1; vk < 255; vk++) {
+        auto color = colorize_config.per_key.find(vk_code_to_key_name(vk));
+        if (color != colorize_config.per_key.end()) {
+            key_colors[vk] = color->second;
+        }
+    }
+    g_renderer->set_colorize(colorize_config, key_colors);
+    
+#ifdef DEBUG
+    int parity_error = g_renderer->check_colorize_parity();
+    if (parity_error >= 0) {
+        LOG_INFO("Colorize shader vs two pass: max rgb difference " << parity_error);
+    }
+#endif
 
     InitAudioDevice();
     
@@ -429,18 +1558,44 @@ int main()
 
     LOG_INFO("Loading audio files from config...");
     
-    g_main_sound = LoadSound(config.main_sound.c_str());
-    if (g_main_sound.frameCount == 0) {
+    g_streamer.set_config(config.streaming);
+    
+    if (config.main_synth) {
+        g_main_synth = g_synth.add_preset(config.main_synth_params);
+    } else if (g_streamer.should_stream(config.main_sound)) {
+        g_main_stream = g_streamer.load(config.main_sound);
+    }
+    if (!g_main_stream && !config.main_synth) {
+        g_main_sound = g_samples.load(config.main_sound);
+    }
+    if (g_main_sound.frameCount == 0 && !g_main_stream && g_main_synth < 0) {
         LOG_ERROR("'" << config.main_sound << "' is required but could not be loaded");
+        g_streamer.unload();
+        g_samples.clear();
         CloseAudioDevice();
         delete g_renderer;
         CloseWindow();
         return 1;
     }
-    LOG_INFO("Loaded main sound: " << config.main_sound);
+    LOG_INFO("Loaded main sound: " << (config.main_synth ? "synth" : config.main_sound) << (g_main_stream ? " (streamed)" : ""));
+    
+    for (const auto& [key_name, params] : config.synth_overrides) {
+        g_key_synths[key_name] = g_synth.add_preset(params);
+        LOG_INFO("Loaded override synth for '" << key_name << "': " << params.pitch << " Hz");
+    }
+    
+    compile_bindings(config.bindings);
     
     for (const auto& [key_name, sound_file] : config.per_key_overrides) {
-        Sound sound = LoadSound(sound_file.c_str());
+        if (g_streamer.should_stream(sound_file)) {
+            if (StreamedSound* stream = g_streamer.load(sound_file)) {
+                g_key_streams[key_name] = stream;
+                LOG_INFO("Loaded override sound for '" << key_name << "': " << sound_file << " (streamed)");
+                continue;
+            }
+        }
+        
+        Sound sound = g_samples.load(sound_file);
         if (sound.frameCount > 0) {
             g_key_sounds[key_name] = sound;
             LOG_INFO("Loaded override sound for '" << key_name << "': " << sound_file);
@@ -449,10 +1604,33 @@ int main()
         }
     }
     
-    LOG_INFO("Audio files loaded successfully");
+    [[maybe_unused]] const SampleCacheStats& sample_stats = g_samples.get_stats();
+    LOG_INFO("Audio files loaded successfully: " << sample_stats.files << " files, " << sample_stats.unique << " unique, "
+             << sample_stats.stored_bytes / 1024 << " KB of samples (" << sample_stats.saved_bytes / 1024 << " KB saved by sharing)");
+    
+    g_streamer.start();
+    if (g_streamer.get_voice_count() > 0) {
+        LOG_INFO("Streaming voices: " << g_streamer.get_voice_count() << ", " << g_streamer.get_memory_bytes() / 1024 << " KB");
+    }
+    
+    if (g_synth.has_presets() && !g_synth.start()) {
+        LOG_WARNING("Failed to start the click synth, synth keys will fall back to the main sound");
+        g_key_synths.clear();
+        if (g_main_synth >= 0) {
+            g_main_synth = -1;
+            g_main_sound = g_samples.load(Config().main_sound);
+        }
+    }
 
-    g_keyboard_hook = SetWindowsHookEx(WH_KEYBOARD_LL, keyboard_hook_proc, GetModuleHandle(NULL), 0);
-    if (!g_keyboard_hook) {
+    if (!config.stats_file.empty()) {
+        if (g_stats.open(config.stats_file)) {
+            LOG_INFO("Typing statistics: " << config.stats_file << ", session " << g_stats.get_sessions());
+        } else {
+            LOG_WARNING("Could not map '" << config.stats_file << "', typing statistics won't be saved");
+        }
+    }
+
+    if (!install_keyboard_hook(config.input_thread)) {
         LOG_ERROR("Failed to install keyboard hook");
 #ifdef RELEASE
         MessageBoxA(NULL, "Failed to install keyboard hook", 
@@ -463,9 +1641,44 @@ int main()
         return 1;
     }
 
-    LOG_INFO("Global keyboard hook active");
+    LOG_INFO("Global keyboard hook active" << (config.input_thread ? " on its own thread" : ""));
+
+    OverlayCapture capture;
+    start_or_stop_capture(capture, config.capture, target_fps);
+    
+    // starts from what the renderer was given, the control thread owns it from here on
+    g_control_colorize = colorize_config;
+    ControlServer control;
+    if (config.control.enabled) {
+        if (control.start(config.control.pipe, handle_control_request)) {
+            LOG_INFO("Control endpoint listening on " << control.get_path());
+        } else {
+            LOG_WARNING("Could not open the control endpoint " << ControlServer::pipe_path(config.control.pipe));
+        }
+    }
+    uint64_t frame_count = 0;
+    double frame_total_ms = 0.0;
+    float frame_max_ms = 0.0f;
+    double last_present = GetTime();
+    
+    const double frame_period = 1.0 / target_fps;
+    const double late_latch_margin = 0.001;
+    double next_present = GetTime() + frame_period;
+    double render_estimate = 0.002;
+    double last_latency_report = GetTime();
 
     while (!WindowShouldClose() && g_running) {
+        // sleep until just before the deadline so input is latched as late as possible
+        if (config.low_latency) {
+            double wake = next_present - render_estimate - late_latch_margin;
+            double now = GetTime();
+            if (wake > now) {
+                WaitTime(wake - now);
+            }
+        }
+        
+        double frame_start = GetTime();
+        
         BeginDrawing();
         
         ClearBackground((Color){0, 0, 0, 0});
@@ -474,28 +1687,103 @@ int main()
             g_renderer->update_and_render();
         }
         
+        if (g_capture_toggle.exchange(false)) {
+            config.capture.enabled = !capture.is_running();
+            start_or_stop_capture(capture, config.capture, target_fps);
+        }
+        if (capture.is_running() && g_renderer) {
+            capture.capture(g_renderer->get_damage());
+        }
+        
         EndDrawing();
+        
+        double frame_end = GetTime();
+        
+        if (g_renderer) {
+            g_renderer->on_presented();
+        }
+        
+        if (control.is_running() && g_renderer) {
+            if (g_reset_counters.exchange(false)) {
+                frame_count = 0;
+                frame_total_ms = 0.0;
+                frame_max_ms = 0.0f;
+                g_hook_latency.reset();
+                g_streamer.reset_counters();
+                g_renderer->reset_counters();
+            }
+            if (g_colorize_requests.acquire()) {
+                g_renderer->set_colorize(g_colorize_requests.read_buffer());
+            }
+            
+            float frame_ms = (float)((frame_end - last_present) * 1000.0);
+            frame_count++;
+            frame_total_ms += frame_ms;
+            frame_max_ms = std::max(frame_max_ms, frame_ms);
+            publish_overlay_stats(frame_count, frame_ms, frame_total_ms, frame_max_ms);
+        }
+        last_present = frame_end;
+        
+        if (config.low_latency) {
+            render_estimate += ((frame_end - frame_start) - render_estimate) * 0.1;
+            next_present += frame_period;
+            if (next_present < frame_end) {
+                next_present = frame_end + frame_period;
+            }
+        }
+        
+        if (config.latency_report && g_renderer && frame_end - last_latency_report >= 10.0) {
+            LOG_INFO("Spawn to present latency: " << g_renderer->get_present_latency().summary());
+            last_latency_report = frame_end;
+        }
     }
 
-    if (g_keyboard_hook) {
-        UnhookWindowsHookEx(g_keyboard_hook);
-        g_keyboard_hook = nullptr;
+    control.stop();
+    if (config.control.enabled) {
+        LOG_INFO("Control endpoint: " << control.get_request_count() << " requests");
     }
+    remove_keyboard_hook();
+    g_stats.close();
+    
+    config.capture.enabled = false;
+    start_or_stop_capture(capture, config.capture, target_fps);
+    
+    LOG_INFO("Hook dispatch latency (" << (config.input_thread ? "input thread" : "render thread") << "): "
+             << g_hook_latency.summary());
 
-    if (g_main_sound.frameCount > 0) {
-        UnloadSound(g_main_sound);
+    if (g_streamer.get_voice_count() > 0) {
+        LOG_INFO("Streaming: " << g_streamer.get_steal_count() << " voices stolen, " << g_streamer.get_drop_count() << " plays dropped");
     }
     
-    for (auto& [key_name, sound] : g_key_sounds) {
-        if (sound.frameCount > 0) {
-            UnloadSound(sound);
-        }
-    }
+    // the cache and the streamer own every sound handed out
+    g_main_sound = Sound{};
+    g_main_stream = nullptr;
     g_key_sounds.clear();
+    g_key_streams.clear();
+    g_key_synths.clear();
+    g_binding_actions.clear();
+    g_main_synth = -1;
+    g_synth.unload();
+    g_streamer.unload();
+    g_samples.clear();
     
     CloseAudioDevice();
     
     if (g_renderer) {
+        [[maybe_unused]] const EffectSimulation& simulation = g_renderer->get_simulation();
+        LOG_INFO("Simulation: " << simulation.get_tick_count() << " ticks, avg " << simulation.get_average_step_us() << " us per tick");
+        LOG_INFO("Spawn to present latency: " << g_renderer->get_present_latency().summary());
+        LOG_INFO("Budget: " << simulation.get_coalesced_count() << " effects coalesced, " << simulation.get_shed_count() << " shed, "
+                 << g_renderer->get_quality().get_degrade_count() << " quality drops");
+        [[maybe_unused]] OverdrawStats overdraw = g_renderer->get_overdraw();
+        LOG_INFO("Placement: " << overdraw.placed << " placed, overdraw avg " << overdraw.average << " max " << overdraw.max
+                 << ", " << overdraw.rejected << " skipped");
+        const GlyphAtlas& atlas = g_renderer->get_glyph_atlas();
+        if (atlas.is_loaded()) {
+            LOG_INFO("Glyph atlas: " << atlas.get_hits() << " hits, " << atlas.get_misses() << " misses, "
+                     << atlas.get_evictions() << " evictions, " << (int)(atlas.get_hit_rate() * 100.0) << "% hit rate");
+        }
+        
         delete g_renderer;
         g_renderer = nullptr;
     }
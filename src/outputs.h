@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+#include <raylib.h>
+#include "definitions.h"
+
+// one monitor covered by the overlay window, in window coordinates
+struct OutputRegion {
+    int monitor;
+    float x, y;
+    float width, height;
+    float dpi_scale;
+    int refresh_rate;
+};
+
+// virtual desktop rectangle covering every region, used to size the overlay
+struct OutputBounds {
+    int x, y;
+    int width, height;
+};
+
+inline float query_monitor_dpi_scale(int virtual_x, int virtual_y)
+{
+    typedef LONG (__stdcall *GetDpiForMonitorProc)(HMONITOR, int, UINT*, UINT*);
+    
+    static GetDpiForMonitorProc get_dpi_for_monitor = nullptr;
+    static bool resolved = false;
+    if (!resolved) {
+        resolved = true;
+        HMODULE shcore = LoadLibraryA("shcore.dll");
+        if (shcore) {
+            get_dpi_for_monitor = (GetDpiForMonitorProc)GetProcAddress(shcore, "GetDpiForMonitor");
+        }
+    }
+    
+    if (!get_dpi_for_monitor) {
+        return 1.0f;
+    }
+    
+    POINT point = {virtual_x, virtual_y};
+    HMONITOR monitor = MonitorFromPoint(point, MONITOR_DEFAULTTONEAREST);
+    UINT dpi_x = USER_DEFAULT_SCREEN_DPI, dpi_y = USER_DEFAULT_SCREEN_DPI;
+    if (!monitor || get_dpi_for_monitor(monitor, MDT_EFFECTIVE_DPI, &dpi_x, &dpi_y) != 0) {
+        return 1.0f;
+    }
+    
+    return (float)dpi_x / USER_DEFAULT_SCREEN_DPI;
+}
+
+// needs an open window, empty selection means every connected monitor
+inline std::vector<OutputRegion> query_outputs(const std::vector<int>& selection, OutputBounds& bounds)
+{
+    std::vector<int> monitors = selection;
+    int monitor_count = GetMonitorCount();
+    
+    if (monitors.empty()) {
+        for (int i = 0; i < monitor_count; i++) {
+            monitors.push_back(i);
+        }
+    }
+    
+    std::vector<OutputRegion> outputs;
+    int min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+    
+    for (int monitor : monitors) {
+        if (monitor < 0 || monitor >= monitor_count) {
+            continue;
+        }
+        
+        Vector2 position = GetMonitorPosition(monitor);
+        int x = (int)position.x;
+        int y = (int)position.y;
+        int w = GetMonitorWidth(monitor);
+        int h = GetMonitorHeight(monitor);
+        
+        if (outputs.empty()) {
+            min_x = x; min_y = y;
+            max_x = x + w; max_y = y + h;
+        } else {
+            if (x < min_x) min_x = x;
+            if (y < min_y) min_y = y;
+            if (x + w > max_x) max_x = x + w;
+            if (y + h > max_y) max_y = y + h;
+        }
+        
+        OutputRegion output;
+        output.monitor = monitor;
+        output.x = (float)x;
+        output.y = (float)y;
+        output.width = (float)w;
+        output.height = (float)h;
+        output.dpi_scale = query_monitor_dpi_scale(x + w / 2, y + h / 2);
+        output.refresh_rate = GetMonitorRefreshRate(monitor);
+        outputs.push_back(output);
+    }
+    
+    // window coordinates start at the top left of the combined rectangle
+    for (auto& output : outputs) {
+        output.x -= min_x;
+        output.y -= min_y;
+    }
+    
+    bounds = {min_x, min_y, max_x - min_x, max_y - min_y};
+    return outputs;
+}
+
+// output under the center of the focused window, -1 if none of ours
+inline int query_focused_output(const std::vector<OutputRegion>& outputs, const OutputBounds& bounds)
+{
+    HWND foreground = GetForegroundWindow();
+    RECT rect;
+    if (!foreground || !GetWindowRect(foreground, &rect)) {
+        return -1;
+    }
+    
+    float cx = (rect.left + rect.right) / 2.0f - bounds.x;
+    float cy = (rect.top + rect.bottom) / 2.0f - bounds.y;
+    
+    for (size_t i = 0; i < outputs.size(); i++) {
+        const OutputRegion& output = outputs[i];
+        if (cx >= output.x && cx < output.x + output.width &&
+            cy >= output.y && cy < output.y + output.height) {
+            return (int)i;
+        }
+    }
+    
+    return -1;
+}
+
+// bottom left of the focused window's text caret in overlay coordinates,
+// false when the app doesn't use a system caret
+inline bool query_caret_position(const OutputBounds& bounds, float point[2])
+{
+    GUITHREADINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!GetGUIThreadInfo(0, &info) || !info.hwndCaret) {
+        return false;
+    }
+    
+    POINT caret = {info.rcCaret.left, info.rcCaret.bottom};
+    if (!ClientToScreen(info.hwndCaret, &caret)) {
+        return false;
+    }
+    
+    point[0] = (float)(caret.x - bounds.x);
+    point[1] = (float)(caret.y - bounds.y);
+    return true;
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <raylib.h>
+#include <rlgl.h>
+#include "capture_encoder.h"
+#include "latency_histogram.h"
+
+struct CaptureConfig {
+    bool enabled = false;       // start capturing right away, the "capture" binding toggles it
+    std::string path = "capture";
+    CaptureFormat format = CaptureFormat::Y4M;
+    int buffers = 3;            // readbacks in flight, frames of latency before a frame is dropped
+    int queue = 8;              // frames waiting for the encoder
+};
+
+// raylib doesn't expose the gl loader it uses, glfw hands out the same entry points
+typedef void (*GLFWglproc)(void);
+extern "C" GLFWglproc glfwGetProcAddress(const char* procname);
+
+// reads rendered frames back through a ring of pixel pack buffers. a frame's
+// copy is only queued on the gpu, it's mapped a few frames later once its
+// fence has passed, so the render thread never waits on the readback. only
+// the damaged rectangle is read, the encoder keeps the rest of the frame
+class OverlayCapture {
+public:
+    OverlayCapture() = default;
+
+    OverlayCapture(const OverlayCapture&) = delete;
+    OverlayCapture& operator=(const OverlayCapture&) = delete;
+
+    ~OverlayCapture() {
+        stop();
+    }
+
+    // render thread, needs the gl context
+    bool start(const CaptureConfig& capture_config, int frame_width, int frame_height, int fps) {
+        stop();
+        if (!load_gl()) return false;
+
+        config = capture_config;
+        width = frame_width;
+        height = frame_height;
+
+        if (!encoder.start(config.path, config.format, width, height, fps, config.queue)) {
+            return false;
+        }
+
+        slots.assign(std::max(config.buffers, 2), Slot{});
+        for (Slot& slot : slots) {
+            gl.GenBuffers(1, &slot.buffer);
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            gl.BufferData(GL_PIXEL_PACK_BUFFER, (intptr_t)width * height * 4, nullptr, GL_STREAM_READ);
+        }
+        gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        next_slot = 0;
+        oldest_slot = 0;
+        in_flight = 0;
+        full_frame = true;
+        skipped = 0;
+        return true;
+    }
+
+    // render thread, waits for the readbacks still in flight and for the
+    // encoder to take them, so the video ends with every captured frame
+    void stop() {
+        if (slots.empty()) return;
+
+        while (in_flight > 0) {
+            collect(true);
+        }
+        if (skipped > 0) {
+            if (CaptureFrame* frame = encoder.acquire(true)) {
+                frame->width = frame->height = 0;
+                frame->repeats_before = skipped - 1;
+                encoder.submit(frame);
+            }
+            skipped = 0;
+        }
+        for (Slot& slot : slots) {
+            gl.DeleteBuffers(1, &slot.buffer);
+        }
+        slots.clear();
+        encoder.stop();
+    }
+
+    bool is_running() const {
+        return !slots.empty();
+    }
+
+    // render thread, after the frame is drawn and before it's presented.
+    // damage is what changed since the previous frame, in frame pixels
+    void capture(Rectangle damage) {
+        if (slots.empty()) return;
+
+        collect(false);
+        frames++;
+
+        if (in_flight == slots.size()) {
+            // the gpu is a whole ring behind, what this frame changed is lost
+            // so the next one has to be read in full. the video still gets a
+            // copy of the previous frame in its place
+            dropped++;
+            skipped++;
+            full_frame = true;
+            return;
+        }
+        Slot& slot = slots[next_slot];
+        slot.repeats_before = skipped;
+        skipped = 0;
+
+        int x0 = 0, y0 = 0, x1 = width, y1 = height;
+        if (!full_frame) {
+            x0 = std::clamp((int)damage.x, 0, width);
+            y0 = std::clamp((int)damage.y, 0, height);
+            x1 = std::clamp((int)(damage.x + damage.width + 1.0f), 0, width);
+            y1 = std::clamp((int)(damage.y + damage.height + 1.0f), 0, height);
+        }
+        slot.x = x0;
+        slot.y = y0;
+        slot.width = std::max(x1 - x0, 0);
+        slot.height = std::max(y1 - y0, 0);
+        slot.issued = std::chrono::steady_clock::now();
+        slot.fence = nullptr;
+        full_frame = false;
+
+        // nothing changed, the frame still goes through the ring to keep the order
+        if (slot.width > 0 && slot.height > 0) {
+            rlDrawRenderBatchActive();
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            gl.PixelStorei(GL_PACK_ALIGNMENT, 1);
+            gl.ReadPixels(slot.x, height - slot.y - slot.height, slot.width, slot.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        next_slot = (next_slot + 1) % slots.size();
+        in_flight++;
+    }
+
+    uint64_t get_frames() const {
+        return frames;
+    }
+
+    // ring full or encoder queue full
+    uint64_t get_dropped() const {
+        return dropped;
+    }
+
+    uint64_t get_written() const {
+        return encoder.get_written();
+    }
+
+    // frame issued to readback mapped
+    const LatencyHistogram& get_readback_latency() const {
+        return readback_latency;
+    }
+
+    const std::string& get_output_path() const {
+        return encoder.get_output_path();
+    }
+
+private:
+    typedef struct __GLsync* GLsync;
+
+    static constexpr unsigned int GL_PIXEL_PACK_BUFFER = 0x88EB;
+    static constexpr unsigned int GL_STREAM_READ = 0x88E1;
+    static constexpr unsigned int GL_PACK_ALIGNMENT = 0x0D05;
+    static constexpr unsigned int GL_RGBA = 0x1908;
+    static constexpr unsigned int GL_UNSIGNED_BYTE = 0x1401;
+    static constexpr unsigned int GL_MAP_READ_BIT = 0x0001;
+    static constexpr unsigned int GL_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+    static constexpr unsigned int GL_SYNC_FLUSH_COMMANDS_BIT = 0x0001;
+    static constexpr unsigned int GL_ALREADY_SIGNALED = 0x911A;
+    static constexpr unsigned int GL_CONDITION_SATISFIED = 0x911C;
+
+    struct Slot {
+        unsigned int buffer = 0;
+        GLsync fence = nullptr;
+        int x = 0, y = 0, width = 0, height = 0;
+        int repeats_before = 0;
+        std::chrono::steady_clock::time_point issued;
+    };
+
+    // only the gl 3.3 entry points raylib itself doesn't wrap
+    struct {
+        void (__stdcall *GenBuffers)(int, unsigned int*);
+        void (__stdcall *DeleteBuffers)(int, const unsigned int*);
+        void (__stdcall *BindBuffer)(unsigned int, unsigned int);
+        void (__stdcall *BufferData)(unsigned int, intptr_t, const void*, unsigned int);
+        void (__stdcall *PixelStorei)(unsigned int, int);
+        void (__stdcall *ReadPixels)(int, int, int, int, unsigned int, unsigned int, void*);
+        void* (__stdcall *MapBufferRange)(unsigned int, intptr_t, intptr_t, unsigned int);
+        unsigned char (__stdcall *UnmapBuffer)(unsigned int);
+        GLsync (__stdcall *FenceSync)(unsigned int, unsigned int);
+        unsigned int (__stdcall *ClientWaitSync)(GLsync, unsigned int, uint64_t);
+        void (__stdcall *DeleteSync)(GLsync);
+    } gl = {};
+
+    bool load_gl() {
+        if (gl.DeleteSync) return true;
+
+        gl.GenBuffers = (decltype(gl.GenBuffers))glfwGetProcAddress("glGenBuffers");
+        gl.DeleteBuffers = (decltype(gl.DeleteBuffers))glfwGetProcAddress("glDeleteBuffers");
+        gl.BindBuffer = (decltype(gl.BindBuffer))glfwGetProcAddress("glBindBuffer");
+        gl.BufferData = (decltype(gl.BufferData))glfwGetProcAddress("glBufferData");
+        gl.PixelStorei = (decltype(gl.PixelStorei))glfwGetProcAddress("glPixelStorei");
+        gl.ReadPixels = (decltype(gl.ReadPixels))glfwGetProcAddress("glReadPixels");
+        gl.MapBufferRange = (decltype(gl.MapBufferRange))glfwGetProcAddress("glMapBufferRange");
+        gl.UnmapBuffer = (decltype(gl.UnmapBuffer))glfwGetProcAddress("glUnmapBuffer");
+        gl.FenceSync = (decltype(gl.FenceSync))glfwGetProcAddress("glFenceSync");
+        gl.ClientWaitSync = (decltype(gl.ClientWaitSync))glfwGetProcAddress("glClientWaitSync");
+        gl.DeleteSync = (decltype(gl.DeleteSync))glfwGetProcAddress("glDeleteSync");
+
+        bool complete = gl.GenBuffers && gl.DeleteBuffers && gl.BindBuffer && gl.BufferData && gl.PixelStorei &&
+                        gl.ReadPixels && gl.MapBufferRange && gl.UnmapBuffer && gl.FenceSync && gl.ClientWaitSync && gl.DeleteSync;
+        if (!complete) {
+            gl = {};
+        }
+        return complete;
+    }
+
+    // hands every finished readback to the encoder, oldest first so frames stay in order
+    void collect(bool wait) {
+        while (in_flight > 0) {
+            Slot& slot = slots[oldest_slot];
+
+            if (slot.fence) {
+                uint64_t timeout = wait ? 1000000000ull : 0;
+                unsigned int status = gl.ClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED && !wait) {
+                    return;
+                }
+                gl.DeleteSync(slot.fence);
+                slot.fence = nullptr;
+            }
+
+            CaptureFrame* frame = encoder.acquire(wait);
+            if (frame) {
+                frame->x = slot.x;
+                frame->y = slot.y;
+                frame->width = slot.width;
+                frame->height = slot.height;
+                frame->repeats_before = slot.repeats_before;
+
+                size_t bytes = (size_t)slot.width * slot.height * 4;
+                frame->pixels.resize(bytes);
+                if (bytes > 0) {
+                    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+                    const void* mapped = gl.MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (intptr_t)bytes, GL_MAP_READ_BIT);
+                    if (mapped) {
+                        std::memcpy(frame->pixels.data(), mapped, bytes);
+                        gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                    } else {
+                        frame->width = frame->height = 0;
+                        full_frame = true;
+                    }
+                    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                }
+
+                readback_latency.record_us(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - slot.issued).count());
+                encoder.submit(frame);
+            } else {
+                // encoder is behind, the frames already in the ring miss this
+                // rectangle until the full read that follows. the next frame
+                // written repeats the one before in its place
+                dropped++;
+                full_frame = true;
+                if (in_flight > 1) {
+                    slots[(oldest_slot + 1) % slots.size()].repeats_before += slot.repeats_before + 1;
+                } else {
+                    skipped += slot.repeats_before + 1;
+                }
+            }
+
+            oldest_slot = (oldest_slot + 1) % slots.size();
+            in_flight--;
+        }
+    }
+
+    CaptureConfig config;
+    CaptureEncoder encoder;
+    int width = 0;
+    int height = 0;
+
+    std::vector<Slot> slots;
+    size_t next_slot = 0;
+    size_t oldest_slot = 0;
+    size_t in_flight = 0;
+    bool full_frame = true;     // the encoder's copy is stale, read everything
+    int skipped = 0;            // dropped since the last issued frame
+
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+    LatencyHistogram readback_latency;
+};
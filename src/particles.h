@@ -0,0 +1,280 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <raylib.h>
+#include <rlgl.h>
+#include <raymath.h>
+
+struct EmitterConfig {
+    std::string name = "embers";
+    int count = 64;             // particles per key press
+    int capacity = 4096;        // max live particles, oldest get overwritten
+    float lifetime = 0.9f;      // seconds
+    float speed = 240.0f;       // px/s
+    float spread = 120.0f;      // degrees, centered upwards
+    float gravity = 420.0f;     // px/s^2, positive is down
+    float size = 3.0f;          // px
+    bool additive = true;
+    Color color = {255, 150, 40, 255};
+};
+
+struct ParticleInstance {
+    float x, y;
+    float spawn_time;
+    float seed;
+};
+
+// per-particle motion lives in the vertex shader, the cpu only writes spawn
+// position/time/seed into a ring buffer and issues one instanced draw
+static const char* PARTICLE_VS = R"(
+#version 330
+in vec2 vertexPosition;
+in vec4 instanceData;
+uniform mat4 mvp;
+uniform float u_time;
+uniform float u_lifetime;
+uniform float u_speed;
+uniform float u_spread;
+uniform float u_gravity;
+uniform float u_size;
+out vec2 fragCorner;
+out float fragLife;
+
+float hash(float n) { return fract(sin(n) * 43758.5453123); }
+
+void main() {
+    float age = u_time - instanceData.z;
+    fragLife = age / u_lifetime;
+    fragCorner = vertexPosition;
+    if (age < 0.0 || fragLife >= 1.0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    float seed = instanceData.w;
+    float angle = radians(-90.0 + (hash(seed) - 0.5) * u_spread);
+    float speed = u_speed * (0.35 + 0.65 * hash(seed + 17.0));
+    vec2 velocity = vec2(cos(angle), sin(angle)) * speed;
+    vec2 pos = instanceData.xy + velocity * age + vec2(0.0, 0.5 * u_gravity * age * age);
+    float size = u_size * (0.5 + hash(seed + 31.0)) * (1.0 - fragLife * 0.5);
+    gl_Position = mvp * vec4(pos + vertexPosition * size, 0.0, 1.0);
+}
+)";
+
+static const char* PARTICLE_FS = R"(
+#version 330
+in vec2 fragCorner;
+in float fragLife;
+uniform vec4 u_color;
+out vec4 finalColor;
+
+void main() {
+    float d = dot(fragCorner, fragCorner);
+    if (d > 1.0) discard;
+    finalColor = vec4(u_color.rgb, u_color.a * (1.0 - d) * (1.0 - fragLife));
+}
+)";
+
+class ParticleEmitter {
+public:
+    explicit ParticleEmitter(const EmitterConfig& cfg) : config(cfg) {}
+
+    ParticleEmitter(const ParticleEmitter&) = delete;
+    ParticleEmitter& operator=(const ParticleEmitter&) = delete;
+
+    ParticleEmitter(ParticleEmitter&& other) noexcept
+        : config(std::move(other.config))
+        , shader(other.shader)
+        , locs(other.locs)
+        , vao(other.vao)
+        , quad_vbo(other.quad_vbo)
+        , instance_vbo(other.instance_vbo)
+        , instances(std::move(other.instances))
+        , head(other.head)
+        , dirty_begin(other.dirty_begin)
+        , dirty_end(other.dirty_end)
+        , serial(other.serial)
+        , epoch(other.epoch)
+        , last_emit(other.last_emit)
+        , drawn_epoch(other.drawn_epoch)
+        , drawn_last_emit(other.drawn_last_emit)
+    {
+        other.shader = {0};
+        other.vao = other.quad_vbo = other.instance_vbo = 0;
+    }
+
+    ~ParticleEmitter() {
+        unload();
+    }
+
+    bool init() {
+        if (config.capacity <= 0) config.capacity = 1;
+        if (config.count > config.capacity) config.count = config.capacity;
+        if (config.lifetime <= 0.0f) config.lifetime = 0.01f;
+
+        shader = LoadShaderFromMemory(PARTICLE_VS, PARTICLE_FS);
+        if (shader.id == 0) {
+            return false;
+        }
+
+        locs.mvp = GetShaderLocation(shader, "mvp");
+        locs.time = GetShaderLocation(shader, "u_time");
+        locs.lifetime = GetShaderLocation(shader, "u_lifetime");
+        locs.speed = GetShaderLocation(shader, "u_speed");
+        locs.spread = GetShaderLocation(shader, "u_spread");
+        locs.gravity = GetShaderLocation(shader, "u_gravity");
+        locs.size = GetShaderLocation(shader, "u_size");
+        locs.color = GetShaderLocation(shader, "u_color");
+        int instance_loc = GetShaderLocationAttrib(shader, "instanceData");
+
+        // dead until written, spawn time far in the past
+        instances.assign(config.capacity, ParticleInstance{0.0f, 0.0f, -1.0e9f, 0.0f});
+
+        static const float quad[12] = {
+            -1.0f, -1.0f,   1.0f, -1.0f,   1.0f,  1.0f,
+            -1.0f, -1.0f,   1.0f,  1.0f,  -1.0f,  1.0f,
+        };
+
+        vao = rlLoadVertexArray();
+        rlEnableVertexArray(vao);
+
+        quad_vbo = rlLoadVertexBuffer(quad, sizeof(quad), false);
+        rlSetVertexAttribute(0, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(0);
+
+        instance_vbo = rlLoadVertexBuffer(instances.data(), (int)(instances.size() * sizeof(ParticleInstance)), true);
+        rlSetVertexAttribute(instance_loc, 4, RL_FLOAT, false, 0, 0);
+        rlSetVertexAttributeDivisor(instance_loc, 1);
+        rlEnableVertexAttribute(instance_loc);
+
+        rlDisableVertexBuffer();
+        rlDisableVertexArray();
+
+        return vao > 0 && instance_vbo > 0;
+    }
+
+    // any thread as long as calls are serialized with upload()
+    void emit(float x, float y, double now, float count_scale = 1.0f) {
+        int count = (int)(config.count * count_scale);
+        if (instance_vbo == 0 || count <= 0) return;
+
+        // restart the clock so float time keeps its precision, cheap while everything is dead
+        if (now - last_emit > config.lifetime || now - epoch > 3600.0) {
+            rebase(now);
+        }
+        last_emit = now;
+
+        float spawn_time = (float)(now - epoch);
+        for (int i = 0; i < count; i++) {
+            instances[head] = {x, y, spawn_time, (float)(serial++ & 0xFFFFF)};
+            mark_dirty(head);
+            head = (head + 1) % instances.size();
+        }
+    }
+
+    // render thread, pushes what emit() wrote since the last call
+    void upload() {
+        if (dirty_begin > dirty_end) return;
+
+        size_t count = dirty_end - dirty_begin + 1;
+        rlUpdateVertexBuffer(instance_vbo, &instances[dirty_begin],
+                             (int)(count * sizeof(ParticleInstance)),
+                             (int)(dirty_begin * sizeof(ParticleInstance)));
+
+        dirty_begin = 1;
+        dirty_end = 0;
+        drawn_epoch = epoch;
+        drawn_last_emit = last_emit;
+    }
+
+    void draw(double now) {
+        if (instance_vbo == 0 || now - drawn_last_emit > config.lifetime) return;
+
+        float time = (float)(now - drawn_epoch);
+        float color[4] = {
+            config.color.r / 255.0f, config.color.g / 255.0f,
+            config.color.b / 255.0f, config.color.a / 255.0f
+        };
+
+        rlDrawRenderBatchActive();
+        BeginBlendMode(config.additive ? BLEND_ADDITIVE : BLEND_ALPHA);
+
+        SetShaderValueMatrix(shader, locs.mvp, MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+        SetShaderValue(shader, locs.time, &time, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, locs.lifetime, &config.lifetime, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, locs.speed, &config.speed, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, locs.spread, &config.spread, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, locs.gravity, &config.gravity, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, locs.size, &config.size, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, locs.color, color, SHADER_UNIFORM_VEC4);
+
+        rlEnableShader(shader.id);
+        rlEnableVertexArray(vao);
+        rlDrawVertexArrayInstanced(0, 6, (int)instances.size());
+        rlDisableVertexArray();
+        rlDisableShader();
+
+        EndBlendMode();
+    }
+
+    // true while particles from the last upload are still on screen
+    bool is_active(double now) const {
+        return instance_vbo != 0 && now - drawn_last_emit <= config.lifetime;
+    }
+
+    const EmitterConfig& get_config() const {
+        return config;
+    }
+
+private:
+    void unload() {
+        if (instance_vbo > 0) rlUnloadVertexBuffer(instance_vbo);
+        if (quad_vbo > 0) rlUnloadVertexBuffer(quad_vbo);
+        if (vao > 0) rlUnloadVertexArray(vao);
+        if (shader.id > 0) UnloadShader(shader);
+        instance_vbo = quad_vbo = vao = 0;
+        shader = {0};
+    }
+
+    // only the written span goes to the gpu, a wrap just widens it
+    void mark_dirty(size_t index) {
+        if (dirty_begin > dirty_end) {
+            dirty_begin = dirty_end = index;
+        } else if (index < dirty_begin) {
+            dirty_begin = index;
+        } else if (index > dirty_end) {
+            dirty_end = index;
+        }
+    }
+
+    void rebase(double now) {
+        float shift = (float)(now - epoch);
+        for (auto& p : instances) {
+            p.spawn_time -= shift;
+        }
+        epoch = now;
+        dirty_begin = 0;
+        dirty_end = instances.size() - 1;
+    }
+
+    EmitterConfig config;
+    Shader shader = {0};
+    struct {
+        int mvp, time, lifetime, speed, spread, gravity, size, color;
+    } locs = {};
+    unsigned int vao = 0;
+    unsigned int quad_vbo = 0;
+    unsigned int instance_vbo = 0;
+    std::vector<ParticleInstance> instances;
+    size_t head = 0;
+    size_t dirty_begin = 1;
+    size_t dirty_end = 0;
+    uint32_t serial = 0;
+    double epoch = 0.0;
+    double last_emit = -1.0e9;
+
+    // what the gpu copy was uploaded with, emit() may run ahead on another thread
+    double drawn_epoch = 0.0;
+    double drawn_last_emit = -1.0e9;
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+enum class PlacementBias {
+    NONE,
+    CARET,      // near the text caret of the focused window, when it has one
+    REGION      // near the center of PlacementConfig::region
+};
+
+struct PlacementConfig {
+    float cell_size = 160.0f;       // px at 100% scale, roughly one effect
+    int max_overdraw = 2;           // effects allowed to share a cell
+    PlacementBias bias = PlacementBias::NONE;
+    float region[4] = {0.25f, 0.25f, 0.5f, 0.5f};   // x, y, width, height as fractions of the output
+};
+
+struct OverdrawStats {
+    double average = 0.0;   // effects sharing the chosen cell, 1 means no overlap
+    int max = 0;
+    uint64_t placed = 0;
+    uint64_t rejected = 0;  // every sampled cell was already at max_overdraw
+};
+
+// uniform grid per output. cells with no live effect sit in a free list with
+// a back index, so taking or returning one is O(1). every occupancy is held
+// for the same lifetime, the longest an effect can live, so they expire in
+// placement order and a fifo retires them without scanning. an effect that
+// restarts moves to the back of the fifo under a new ticket, one that goes
+// early (shed, or on a shorter curve) releases its ticket. no windowing
+// calls, it can run headless
+class EffectPlacer {
+public:
+    void configure(const PlacementConfig& cfg, float effect_lifetime) {
+        config = cfg;
+        if (config.cell_size < 16.0f) config.cell_size = 16.0f;
+        config.max_overdraw = std::clamp(config.max_overdraw, 1, 255);
+        lifetime = effect_lifetime;
+        grids.clear();
+        live.clear();
+        front_ticket = next_ticket;     // tickets from before are stale now
+    }
+
+    // one grid per output, in output order
+    void add_region(float x, float y, float width, float height, float scale) {
+        Grid grid;
+        grid.cell = config.cell_size * scale;
+        grid.x = x;
+        grid.y = y;
+        grid.cols = std::max(1, (int)(width / grid.cell));
+        grid.rows = std::max(1, (int)(height / grid.cell));
+        // spread the leftover evenly so cells stay centered in the region
+        grid.x += (width - grid.cols * grid.cell) / 2.0f;
+        grid.y += (height - grid.rows * grid.cell) / 2.0f;
+        grid.width = width;
+        grid.height = height;
+
+        int cells = grid.cols * grid.rows;
+        grid.counts.assign(cells, 0);
+        grid.free_cells.resize(cells);
+        grid.free_slot.resize(cells);
+        for (int i = 0; i < cells; i++) {
+            grid.free_cells[i] = i;
+            grid.free_slot[i] = i;
+        }
+
+        grids.push_back(std::move(grid));
+    }
+
+    // picks a spot for an effect spawned at now (seconds). bias_point is in the
+    // same coordinates as the regions and only used with PlacementBias::CARET.
+    // ticket identifies the occupancy for renew() and release()
+    bool place(int output, double now, const float* bias_point, float& x, float& y, uint32_t& ticket) {
+        if (output < 0 || output >= (int)grids.size()) return false;
+        Grid& grid = grids[output];
+
+        retire(now);
+
+        float target_x = 0.0f, target_y = 0.0f;
+        bool biased = false;
+        if (config.bias == PlacementBias::CARET && bias_point) {
+            target_x = bias_point[0];
+            target_y = bias_point[1];
+            biased = true;
+        } else if (config.bias == PlacementBias::REGION) {
+            target_x = grid.x + grid.width * (config.region[0] + config.region[2] / 2.0f);
+            target_y = grid.y + grid.height * (config.region[1] + config.region[3] / 2.0f);
+            biased = true;
+        }
+
+        // a few random candidates, closest to the target wins. constant work
+        // whatever the grid size, more samples pull harder towards the target
+        int samples = biased ? BIAS_SAMPLES : 1;
+        int best = -1;
+        float best_distance = 0.0f;
+
+        if (!grid.free_cells.empty()) {
+            for (int i = 0; i < samples; i++) {
+                int cell = grid.free_cells[next_random() % grid.free_cells.size()];
+                consider(grid, cell, biased, target_x, target_y, best, best_distance);
+            }
+        } else {
+            // everything is taken, stack on the emptiest sampled cell
+            int least = config.max_overdraw;
+            for (int i = 0; i < OVERFLOW_SAMPLES; i++) {
+                int cell = (int)(next_random() % grid.counts.size());
+                if (grid.counts[cell] < least) {
+                    least = grid.counts[cell];
+                    best = cell;
+                }
+            }
+        }
+
+        if (best < 0) {
+            stats.rejected++;
+            return false;
+        }
+
+        occupy(grid, best);
+        ticket = push_live(output, best, now);
+
+        int overdraw = grid.counts[best];
+        stats.placed++;
+        stats.average += (overdraw - stats.average) / stats.placed;
+        stats.max = std::max(stats.max, overdraw);
+
+        // jitter inside the cell so the grid doesn't show
+        float jitter_x = ((next_random() & 0xFFFF) / 65535.0f - 0.5f) * grid.cell * 0.5f;
+        float jitter_y = ((next_random() & 0xFFFF) / 65535.0f - 0.5f) * grid.cell * 0.5f;
+        x = grid.x + (best % grid.cols + 0.5f) * grid.cell + jitter_x;
+        y = grid.y + (best / grid.cols + 0.5f) * grid.cell + jitter_y;
+        return true;
+    }
+
+    // the effect restarted at now, it keeps its cell for another lifetime.
+    // returns the ticket it has from now on
+    uint32_t renew(uint32_t ticket, double now) {
+        retire(now);
+        Occupancy* occupancy = find_live(ticket);
+        if (!occupancy || occupancy->released) return ticket;
+
+        // the cell stays counted, the old entry just stops releasing it
+        occupancy->released = true;
+        return push_live(occupancy->output, occupancy->cell, now);
+    }
+
+    // the effect went before its lifetime was up, a ticket released or
+    // renewed already is left alone
+    void release(uint32_t ticket) {
+        Occupancy* occupancy = find_live(ticket);
+        if (!occupancy || occupancy->released) return;
+
+        occupancy->released = true;
+        release(grids[occupancy->output], occupancy->cell);
+    }
+
+    const OverdrawStats& get_overdraw() const {
+        return stats;
+    }
+
+    size_t get_live_count() const {
+        return live.size();
+    }
+
+    // cells of an output with no effect in them
+    size_t get_free_count(int output) const {
+        return grids[output].free_cells.size();
+    }
+
+private:
+    static constexpr int BIAS_SAMPLES = 6;
+    static constexpr int OVERFLOW_SAMPLES = 8;
+
+    struct Grid {
+        float x, y, cell;
+        float width, height;
+        int cols, rows;
+        std::vector<uint8_t> counts;
+        std::vector<int> free_cells;
+        std::vector<int> free_slot;     // index into free_cells, -1 when taken
+    };
+
+    struct Occupancy {
+        int output;
+        int cell;
+        double expires;
+        bool released;      // renewed or released early, the cell isn't this entry's anymore
+    };
+
+    uint32_t push_live(int output, int cell, double now) {
+        live.push_back({output, cell, now + lifetime, false});
+        return next_ticket++;
+    }
+
+    // null once the ticket retired, tickets are consecutive from the front of live
+    Occupancy* find_live(uint32_t ticket) {
+        uint32_t index = ticket - front_ticket;
+        return index < live.size() ? &live[index] : nullptr;
+    }
+
+    void consider(const Grid& grid, int cell, bool biased, float target_x, float target_y, int& best, float& best_distance) {
+        float distance = 0.0f;
+        if (biased) {
+            float dx = grid.x + (cell % grid.cols + 0.5f) * grid.cell - target_x;
+            float dy = grid.y + (cell / grid.cols + 0.5f) * grid.cell - target_y;
+            distance = dx * dx + dy * dy;
+        }
+        if (best < 0 || distance < best_distance) {
+            best = cell;
+            best_distance = distance;
+        }
+    }
+
+    void occupy(Grid& grid, int cell) {
+        if (grid.counts[cell]++ == 0) {
+            // swap remove from the free list
+            int slot = grid.free_slot[cell];
+            int last = grid.free_cells.back();
+            grid.free_cells[slot] = last;
+            grid.free_slot[last] = slot;
+            grid.free_cells.pop_back();
+            grid.free_slot[cell] = -1;
+        }
+    }
+
+    void release(Grid& grid, int cell) {
+        if (--grid.counts[cell] == 0) {
+            grid.free_slot[cell] = (int)grid.free_cells.size();
+            grid.free_cells.push_back(cell);
+        }
+    }
+
+    void retire(double now) {
+        while (!live.empty() && live.front().expires <= now) {
+            const Occupancy& occupancy = live.front();
+            if (!occupancy.released) {
+                release(grids[occupancy.output], occupancy.cell);
+            }
+            live.pop_front();
+            front_ticket++;
+        }
+    }
+
+    uint32_t next_random() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    PlacementConfig config;
+    float lifetime = 1.0f;
+    std::vector<Grid> grids;
+    std::deque<Occupancy> live;
+    uint32_t front_ticket = 0;      // ticket of live.front()
+    uint32_t next_ticket = 0;
+    OverdrawStats stats;
+    uint32_t seed = 0x6D2B79F5u;
+};
@@ -2,41 +2,57 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <chrono>
+#include <mutex>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <raylib.h>
 #include "animated_texture.h"
+#include "particles.h"
+#include "simulation.h"
+#include "outputs.h"
+#include "colorize.h"
+#include "latency_histogram.h"
+#include "placement.h"
+#include "glyph_atlas.h"
 
 #if defined(_WIN32)
     #undef NOGDI
     #undef NOUSER
 #endif
 
-struct KeyEffect {
-    std::string key_text;
-    float x, y;
-    float alpha;
-    float scale;
-    std::chrono::steady_clock::time_point start_time;
-    int texture_index;
-    bool active;
-};
-
 class KeyRenderer {
 public:
     KeyRenderer(int screen_width, int screen_height)
-        : width(screen_width), height(screen_height), tint_color({255, 255, 255, 255}) {}
+        : width(screen_width), height(screen_height), tint_color({255, 255, 255, 255}) {
+        outputs.push_back({0, 0.0f, 0.0f, (float)screen_width, (float)screen_height, 1.0f, 60});
+        rebuild_placement();
+    }
     
     ~KeyRenderer() {
+        simulation.stop();
         textures.clear();
+        emitters.clear();
         
         if (custom_font_loaded) {
             UnloadFont(font);
         }
     }
     
-    bool init(const std::vector<std::string>& image_paths, const std::string& font_path = "", Color tint = {255, 255, 255, 255}) {
+    bool init(const std::vector<std::string>& image_paths, const std::string& font_path = "", Color tint = {255, 255, 255, 255},
+              const std::vector<EmitterConfig>& emitter_configs = {}, int simulation_rate = 120,
+              const EffectBudgetConfig& budget = {}, const TextureOptions& texture_options = {}) {
         tint_color = tint;
+        colorize.color = tint;
+        
+        if (colorize_shader.load()) {
+            std::cout << "Loaded colorize shader\n";
+        } else {
+            std::cout << "Warning: Failed to load colorize shader, using two pass colorize\n";
+        }
         
         if (!font_path.empty()) {
             font = LoadFont(font_path.c_str());
@@ -53,12 +69,36 @@ public:
             custom_font_loaded = false;
         }
         
+        // labels can be any character the keyboard layout types, the atlas
+        // rasterizes them on demand from the font and then the fallbacks
+        std::vector<std::string> glyph_sources;
+        if (custom_font_loaded) {
+            glyph_sources.push_back(font_path);
+        }
+        glyph_sources.insert(glyph_sources.end(), fallback_fonts.begin(), fallback_fonts.end());
+        if (!fallback_fonts.empty() && glyph_atlas.load(glyph_sources, glyph_size)) {
+            std::cout << "Loaded glyph atlas from " << glyph_sources.size() << " fonts, " << glyph_size << " px glyphs\n";
+        } else if (!fallback_fonts.empty()) {
+            std::cout << "Warning: Failed to load any font for the glyph atlas, labels are limited to the font's characters\n";
+        }
+        
         textures.reserve(image_paths.size());
         
+        // palette lookups only exist in the colorize shader
+        TextureOptions options = texture_options;
+        if (options.storage == TextureStorage::PALETTE && !colorize_shader.is_loaded()) {
+            std::cout << "Warning: Palettized textures need the colorize shader, storing them as rgba\n";
+            options.storage = TextureStorage::RGBA;
+        }
+        
         for (const auto& image_path : image_paths) {
             AnimatedTexture anim_tex;
-            if (anim_tex.load_from_file(image_path)) {
-                std::cout << "Loaded image: " << image_path << " - texture id: " << anim_tex.get_current_texture().id << "\n";
+            if (anim_tex.load_from_file(image_path, options)) {
+                const TextureReport& report = anim_tex.get_report();
+                std::cout << "Loaded image: " << image_path << " - texture id: " << anim_tex.get_current_texture().id
+                          << " (" << storage_name(report.storage) << ", " << report.frame_count << " frames, "
+                          << report.raw_bytes << " -> " << report.stored_bytes << " bytes, upload "
+                          << report.upload_ms << " ms)\n";
                 textures.push_back(std::move(anim_tex));
             } else {
                 std::cout << "Warning: Failed to load image: " << image_path << "\n";
@@ -69,19 +109,368 @@ public:
             std::cout << "No images loaded, will use default circle rendering\n";
         }
         
+        emitters.reserve(emitter_configs.size());
+        
+        for (const auto& emitter_config : emitter_configs) {
+            ParticleEmitter emitter(emitter_config);
+            if (emitter.init()) {
+                std::cout << "Loaded particle emitter: " << emitter_config.name << " (" << emitter_config.count << " per press)\n";
+                emitters.push_back(std::move(emitter));
+            } else {
+                std::cout << "Warning: Failed to create particle emitter: " << emitter_config.name << "\n";
+            }
+        }
+        
+        simulation.set_budget(budget);
+        simulation.start(simulation_rate);
+        last_frame = std::chrono::steady_clock::now();
+        
         return true;
     }
     
-    void add_key_effect(const std::string& key_text, int vk_code) {
+    void set_outputs(const std::vector<OutputRegion>& regions) {
+        if (!regions.empty()) {
+            outputs = regions;
+        }
+        std::lock_guard<std::mutex> lk(spawn_mutex);
+        rebuild_placement();
+    }
+    
+    void set_placement(const PlacementConfig& config) {
+        std::lock_guard<std::mutex> lk(spawn_mutex);
+        placement = config;
+        rebuild_placement();
+    }
+    
+    // any thread, the input thread updates them while placing
+    OverdrawStats get_overdraw() {
+        std::lock_guard<std::mutex> lk(spawn_mutex);
+        return placer.get_overdraw();
+    }
+    
+    // fonts tried after the main font for characters it doesn't have, call before init
+    void set_glyph_fonts(const std::vector<std::string>& fallbacks, int size) {
+        fallback_fonts = fallbacks;
+        glyph_size = size > 8 ? size : 8;
+    }
+    
+    const GlyphAtlas& get_glyph_atlas() const {
+        return glyph_atlas;
+    }
+    
+    // what this frame changed: everything drawn now plus everything drawn last
+    // frame, which is gone now. width 0 when nothing was drawn in either
+    Rectangle get_damage() const {
+        return merge_rects(drawn_bounds, previous_bounds);
+    }
+    
+    const std::vector<OutputRegion>& get_outputs() const {
+        return outputs;
+    }
+    
+    // output < 0 spawns the effect on every output, safe to call from the input thread.
+    // caret is where placement leans to with the caret bias, in window coordinates
+    void add_key_effect(const std::string& key_text, int vk_code, int output = 0, const float* caret = nullptr) {
+        std::lock_guard<std::mutex> lk(spawn_mutex);
+        
+        if (output >= (int)outputs.size()) {
+            output = 0;
+        }
+        
+        if (output < 0) {
+            for (size_t i = 0; i < outputs.size(); i++) {
+                add_key_effect_on(key_text, vk_code, (int)i, caret);
+            }
+        } else {
+            add_key_effect_on(key_text, vk_code, output, caret);
+        }
+    }
+    
+    void set_colorize(const ColorizeConfig& config, const std::map<int, Color>& colors_by_key) {
+        colorize = config;
+        tint_color = config.color;
+        key_colors = colors_by_key;
+    }
+    
+    // render thread, keeps the per key colors. effects already on screen keep their tint
+    void set_colorize(const ColorizeConfig& config) {
+        std::lock_guard<std::mutex> lk(spawn_mutex);
+        colorize = config;
+        tint_color = config.color;
+    }
+    
+    // renders the first sprite through the old two pass path and through the shader
+    // at a few alphas, returns the largest rgb difference (0-255), -1 if nothing to compare
+    int check_colorize_parity() {
+        if (!colorize_shader.is_loaded() || textures.empty()) {
+            return -1;
+        }
+        
+        const Texture2D& texture = textures[0].get_current_texture();
+        if (texture.id == 0 || textures[0].get_palette().id > 0) {
+            return -1;
+        }
+        
+        static const float alphas[] = {1.0f, 0.75f, 0.5f, 0.25f};
+        const int count = sizeof(alphas) / sizeof(alphas[0]);
+        int cell_width = texture.width * 2;
+        int cell_height = texture.height * 2;
+        
+        KeyEffect effects[count];
+        EffectDraw draws[count];
+        for (int i = 0; i < count; i++) {
+            effects[i] = {};
+            effects[i].x = cell_width * (i + 0.5f);
+            effects[i].y = cell_height * 0.5f;
+            effects[i].tint = tint_color;
+            draws[i] = {&effects[i], alphas[i], 1.0f, 0.0f, {0.0f, 0.0f}, {effects[i].x, effects[i].y}, 0.0f, tint_color};
+        }
+        
+        ColorizeConfig plain;
+        plain.color = tint_color;
+        
+        RenderTexture2D golden = LoadRenderTexture(cell_width * count, cell_height);
+        RenderTexture2D single = LoadRenderTexture(cell_width * count, cell_height);
+        
+        BeginTextureMode(golden);
+        ClearBackground((Color){0, 0, 0, 0});
+        for (const EffectDraw& draw : draws) {
+            render_sprite(draw, texture, false, true);
+        }
+        EndTextureMode();
+        
+        BeginTextureMode(single);
+        ClearBackground((Color){0, 0, 0, 0});
+        colorize_shader.begin(plain, 0.0, GLOW_STRENGTH);
+        for (const EffectDraw& draw : draws) {
+            render_sprite(draw, texture, true, true);
+        }
+        colorize_shader.end();
+        EndTextureMode();
+        
+        Image golden_image = LoadImageFromTexture(golden.texture);
+        Image single_image = LoadImageFromTexture(single.texture);
+        Color* golden_pixels = LoadImageColors(golden_image);
+        Color* single_pixels = LoadImageColors(single_image);
+        
+        int max_error = 0;
+        for (int i = 0; i < golden_image.width * golden_image.height; i++) {
+            int errors[3] = {
+                std::abs(golden_pixels[i].r - single_pixels[i].r),
+                std::abs(golden_pixels[i].g - single_pixels[i].g),
+                std::abs(golden_pixels[i].b - single_pixels[i].b)
+            };
+            for (int error : errors) {
+                if (error > max_error) max_error = error;
+            }
+        }
+        
+        UnloadImageColors(golden_pixels);
+        UnloadImageColors(single_pixels);
+        UnloadImage(golden_image);
+        UnloadImage(single_image);
+        UnloadRenderTexture(golden);
+        UnloadRenderTexture(single);
+        
+        return max_error;
+    }
+    
+    // keyframe curves for every effect, call before init
+    void set_curves(std::vector<EffectCurve> curves, const std::vector<int>& key_curves) {
+        std::lock_guard<std::mutex> lk(spawn_mutex);
+        simulation.set_curves(std::move(curves), key_curves);
+        rebuild_placement();
+    }
+    
+    // draw spawns that arrived after the last simulation tick, for low latency mode
+    void set_late_latch(bool enabled) {
+        late_latch = enabled;
+    }
+    
+    // call right after the frame was presented, closes spawn to present measurements
+    void on_presented() {
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& spawn_time : unpresented_spawns) {
+            present_latency.record_us(std::chrono::duration_cast<std::chrono::microseconds>(now - spawn_time).count());
+        }
+        unpresented_spawns.clear();
+    }
+    
+    const LatencyHistogram& get_present_latency() const {
+        return present_latency;
+    }
+    
+    // frames slower than this make the renderer drop quality
+    void set_frame_time_target(float frame_ms) {
+        quality.set_target(frame_ms);
+    }
+    
+    const QualityController& get_quality() const {
+        return quality;
+    }
+    
+    // effects drawn last frame
+    size_t get_effect_count() const {
+        return draw_list.size();
+    }
+    
+    size_t get_texture_bytes() const {
+        size_t bytes = 0;
+        for (const auto& anim_tex : textures) {
+            bytes += anim_tex.get_report().stored_bytes;
+        }
+        return bytes;
+    }
+    
+    // render thread, zeroes the latency, budget and simulation counters
+    void reset_counters() {
+        present_latency.reset();
+        quality.reset_counters();
+        simulation.reset_counters();
+    }
+    
+    void update_and_render() {
+        auto now = std::chrono::steady_clock::now();
+        float delta_time = std::chrono::duration<float>(now - last_frame).count();
+        last_frame = now;
+        render_frame++;
+        previous_bounds = drawn_bounds;
+        drawn_bounds = {0, 0, 0, 0};
+        
+        quality.record_frame(delta_time * 1000.0f);
+        
+        // degraded quality advances animations less often, or not at all
+        animation_delta += delta_time;
+        int stride = quality.animation_stride();
+        if (stride > 0 && ++animation_frame % stride == 0) {
+            for (auto& anim_tex : textures) {
+                anim_tex.update(animation_delta);
+            }
+            animation_delta = 0.0f;
+        } else if (stride == 0) {
+            animation_delta = 0.0f;
+        }
+        
+        if (simulation.acquire()) {
+            std::swap(previous_snapshot, current_snapshot);
+            const EffectSnapshot& latest = simulation.latest();
+            current_snapshot.time = latest.time;
+            current_snapshot.tick = latest.tick;
+            current_snapshot.last_spawn_id = latest.last_spawn_id;
+            current_snapshot.effects.assign(latest.effects.begin(), latest.effects.end());
+        }
+        
+        // draw one tick in the past so there is always a snapshot on both sides
+        float t = 1.0f;
+        auto render_time = now - simulation.get_tick_duration();
+        if (current_snapshot.time > previous_snapshot.time) {
+            t = std::chrono::duration<float>(render_time - previous_snapshot.time).count() /
+                std::chrono::duration<float>(current_snapshot.time - previous_snapshot.time).count();
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        }
+        
+        // both snapshots are ordered by id, walk them together
+        const auto& previous = previous_snapshot.effects;
+        size_t j = 0;
+        draw_list.clear();
+        
+        for (const KeyEffect& effect : current_snapshot.effects) {
+            while (j < previous.size() && previous[j].id < effect.id) {
+                j++;
+            }
+            
+            CurvePose pose = effect.pose;
+            if (j < previous.size() && previous[j].id == effect.id) {
+                pose = CurvePose::lerp(previous[j].pose, effect.pose, t);
+            }
+            
+            draw_list.push_back(make_draw(effect, pose));
+        }
+        
+        // late latch, presses the simulation hasn't published yet go out this frame at their spawn state
+        if (late_latch) {
+            late_spawns.clear();
+            simulation.collect_unpublished(current_snapshot.last_spawn_id, late_spawns);
+            const auto& published = current_snapshot.effects;
+            for (const KeyEffect& effect : late_spawns) {
+                // already drawn above from the snapshot
+                auto it = std::lower_bound(published.begin(), published.end(), effect.id,
+                                           [](const KeyEffect& e, uint32_t id) { return e.id < id; });
+                if (it != published.end() && it->id == effect.id) continue;
+                draw_list.push_back(make_draw(effect, effect.pose));
+            }
+        }
+        
+        for (const EffectDraw& draw : draw_list) {
+            if (draw.effect->id > last_drawn_id) {
+                last_drawn_id = draw.effect->id;
+                unpresented_spawns.push_back(draw.effect->start_time);
+            }
+        }
+        
+        render_draw_list();
+        
+        // one instanced draw per emitter, on top of every sprite
+        double time = GetTime();
+        {
+            std::lock_guard<std::mutex> lk(spawn_mutex);
+            for (auto& emitter : emitters) {
+                emitter.upload();
+            }
+        }
+        for (auto& emitter : emitters) {
+            // particles fly anywhere, no point bounding them
+            if (emitter.is_active(time)) {
+                drawn_bounds = {0, 0, (float)width, (float)height};
+            }
+            emitter.draw(time);
+        }
+    }
+    
+    const EffectSimulation& get_simulation() const {
+        return simulation;
+    }
+    
+private:
+    void add_key_effect_on(const std::string& key_text, int vk_code, int output, const float* caret) {
+        const OutputRegion& region = outputs[output];
+        
         KeyEffect effect;
+        effect.id = 0;
+        effect.key_code = vk_code;
+        effect.output = output;
         effect.key_text = key_text;
+        effect.start_time = std::chrono::steady_clock::now();
         
-        effect.x = GetRandomValue(100, width - 100);
-        effect.y = GetRandomValue(100, height - 100);
+        double now = std::chrono::duration<double>(effect.start_time.time_since_epoch()).count();
         
-        effect.alpha = 1.0f;
-        effect.scale = 1.0f;
-        effect.start_time = std::chrono::steady_clock::now();
+        // shed effects give their cells back
+        simulation.take_released_placements(released_placements);
+        for (uint32_t ticket : released_placements) {
+            placer.release(ticket);
+        }
+        
+        // a quick repeat grows the effect already there, in its cell for another lifetime,
+        // and particles burst where it is
+        CoalesceTarget target;
+        auto renew = [&](uint32_t ticket) { return placer.renew(ticket, now); };
+        if (simulation.coalesce(output, vk_code, effect.start_time, target, renew)) {
+            for (auto& emitter : emitters) {
+                emitter.emit(target.x, target.y, GetTime(), quality.particle_scale());
+            }
+            return;
+        }
+        
+        // every cell around is at max_overdraw, skip it rather than pile up
+        if (!placer.place(output, now, caret, effect.x, effect.y, effect.placement)) {
+            return;
+        }
+        
+        effect.base_scale = region.dpi_scale;
+        effect.intensity = 1.0f;
+        
+        auto key_color = key_colors.find(vk_code);
+        effect.tint = key_color != key_colors.end() ? key_color->second : tint_color;
         
         if (!textures.empty()) {
             effect.texture_index = GetRandomValue(0, textures.size() - 1);
@@ -91,100 +480,206 @@ public:
         
         effect.active = true;
         
-        active_effects.push_back(effect);
+        for (auto& emitter : emitters) {
+            emitter.emit(effect.x, effect.y, GetTime(), quality.particle_scale());
+        }
+        
+        simulation.spawn(std::move(effect));
     }
     
-    void update_and_render() {
-        auto now = std::chrono::steady_clock::now();
-        static auto last_frame = now;
-        float delta_time = std::chrono::duration<float>(now - last_frame).count();
-        last_frame = now;
+    // effect centers keep the old 100px margin from the output edges
+    void rebuild_placement() {
+        placer.configure(placement, simulation.get_effect_lifetime());
+        for (const OutputRegion& region : outputs) {
+            float inset = std::max(0.0f, (100.0f - placement.cell_size / 2.0f) * region.dpi_scale);
+            placer.add_region(region.x + inset, region.y + inset, region.width - 2 * inset, region.height - 2 * inset, region.dpi_scale);
+        }
+    }
+    
+    static const char* storage_name(TextureStorage storage) {
+        switch (storage) {
+            case TextureStorage::DXT: return "dxt5";
+            case TextureStorage::PALETTE: return "palette";
+            default: return "rgba";
+        }
+    }
+    
+    struct EffectDraw {
+        const KeyEffect* effect;
+        float alpha;
+        float scale;
+        float font_size;
+        Vector2 text_size;
+        Vector2 center;     // position plus the curve's offset
+        float rotation;     // degrees
+        Color tint;         // the effect's tint times the curve's color
+    };
+    
+    EffectDraw make_draw(const KeyEffect& effect, const CurvePose& pose) {
+        // coalesced presses make the effect bigger instead of stacking more of them
+        float scale = pose.scale * effect.base_scale * (1.0f + (effect.intensity - 1.0f) * 0.2f);
         
-        for (auto& anim_tex : textures) {
-            anim_tex.update(delta_time);
+        EffectDraw draw;
+        draw.effect = &effect;
+        draw.alpha = std::clamp(pose.alpha, 0.0f, 1.0f);
+        draw.scale = scale;
+        draw.center = {effect.x + pose.offset_x * effect.base_scale, effect.y + pose.offset_y * effect.base_scale};
+        draw.rotation = pose.rotation;
+        draw.tint = {
+            (unsigned char)(effect.tint.r * pose.red / 255.0f),
+            (unsigned char)(effect.tint.g * pose.green / 255.0f),
+            (unsigned char)(effect.tint.b * pose.blue / 255.0f),
+            effect.tint.a
+        };
+        draw.font_size = (int)(48 * scale);
+        if (glyph_atlas.is_loaded()) {
+            // ids only grow, anything past the last drawn one is on screen for the first time
+            glyph_atlas.prepare(effect.key_text, render_frame, effect.id > last_drawn_id);
         }
+        draw.text_size = MeasureTextEx(label_font(), effect.key_text.c_str(), draw.font_size, 2);
+        return draw;
+    }
+    
+    const Texture2D* sprite_texture(const KeyEffect& effect) const {
+        if (effect.texture_index < 0 || effect.texture_index >= (int)textures.size()) {
+            return nullptr;
+        }
+        const Texture2D& texture = textures[effect.texture_index].get_current_texture();
+        return texture.id > 0 ? &texture : nullptr;
+    }
+    
+    // sprites share one shader/blend state so they batch, text goes on top of all of them
+    void render_draw_list() {
+        bool single_pass = colorize_shader.is_loaded();
         
-        for (auto it = active_effects.begin(); it != active_effects.end();) {
-            KeyEffect& effect = *it;
-            
-            float elapsed = std::chrono::duration<float>(now - effect.start_time).count();
-            
-            float fade_duration = 1.0f;
-            effect.alpha = 1.0f - (elapsed / fade_duration);
-            
-            effect.scale = 1.0f + (elapsed * 0.5f);
-            
-            if (effect.alpha <= 0.0f) {
-                it = active_effects.erase(it);
-                continue;
+        if (single_pass) {
+            colorize_shader.begin(colorize, GetTime(), quality.glow_pass() ? GLOW_STRENGTH : 0.0f);
+        }
+        for (const EffectDraw& draw : draw_list) {
+            if (const Texture2D* texture = sprite_texture(*draw.effect)) {
+                if (single_pass) {
+                    colorize_shader.set_palette(textures[draw.effect->texture_index].get_palette());
+                }
+                render_sprite(draw, *texture, single_pass, quality.glow_pass());
             }
+        }
+        if (single_pass) {
+            colorize_shader.end();
+        }
+        
+        for (const EffectDraw& draw : draw_list) {
+            const KeyEffect& effect = *draw.effect;
             
-            render_effect(effect);
+            if (!sprite_texture(effect)) {
+                Color circle_color = {draw.tint.r, draw.tint.g, draw.tint.b, (unsigned char)(draw.alpha * 200)};
+                DrawCircleV(draw.center, 30 * draw.scale, circle_color);
+                add_drawn(draw.center, 60 * draw.scale, 60 * draw.scale, 0.0f);
+            }
             
-            ++it;
+            // rotates around its center like the sprite under it
+            Color text_color = {255, 255, 255, (unsigned char)(draw.alpha * 255)};
+            Vector2 text_origin = {draw.text_size.x / 2, draw.text_size.y / 2};
+            DrawTextPro(label_font(), effect.key_text.c_str(), draw.center, text_origin, draw.rotation, draw.font_size, 2, text_color);
+            add_drawn(draw.center, draw.text_size.x, draw.text_size.y, draw.rotation);
         }
     }
     
-private:
-    void render_effect(const KeyEffect& effect) {
-        Color text_color = {255, 255, 255, (unsigned char)(effect.alpha * 255)};
+    void render_sprite(const EffectDraw& draw, const Texture2D& texture, bool single_pass, bool glow) {
+        float base_scale = draw.scale;
+        float scale_x = base_scale;
+        float scale_y = base_scale;
         
-        int font_size = 48 * effect.scale;
-        Vector2 text_size = MeasureTextEx(font, effect.key_text.c_str(), font_size, 2);
+        // stretch horizontally for modifiers
+        if (draw.text_size.x > texture.width * base_scale) {
+            scale_x = (draw.text_size.x / texture.width) * 1.2f;
+        }
         
-        if (effect.texture_index >= 0 && effect.texture_index < textures.size()) {
-            const Texture2D& texture = textures[effect.texture_index].get_current_texture();
+        float scaled_width = texture.width * scale_x;
+        float scaled_height = texture.height * scale_y;
+        
+        Rectangle source = {0, 0, (float)texture.width, (float)texture.height};
+        // dest is placed by its center so rotation spins the sprite in place
+        Rectangle dest = {draw.center.x, draw.center.y, scaled_width, scaled_height};
+        Vector2 origin = {scaled_width / 2, scaled_height / 2};
+        add_drawn(draw.center, scaled_width, scaled_height, draw.rotation);
+        
+        if (single_pass) {
+            Color color = {draw.tint.r, draw.tint.g, draw.tint.b, (unsigned char)(draw.alpha * 255)};
+            DrawTexturePro(texture, source, dest, origin, draw.rotation, color);
+            return;
+        }
+        
+        if (glow) {
+            BeginBlendMode(BLEND_ADDITIVE);
             
-            if (texture.id > 0) {
-                float base_scale = effect.scale;
-                float scale_x = base_scale;
-                float scale_y = base_scale;
-                
-                // stretch horizontally for modifiers
-                if (text_size.x > texture.width * base_scale) {
-                    scale_x = (text_size.x / texture.width) * 1.2f;
-                }
-                
-                float scaled_width = texture.width * scale_x;
-                float scaled_height = texture.height * scale_y;
-                
-                Rectangle source = {0, 0, (float)texture.width, (float)texture.height};
-                Rectangle dest = {
-                    effect.x - scaled_width / 2,
-                    effect.y - scaled_height / 2,
-                    scaled_width,
-                    scaled_height
-                };
-                Vector2 origin = {0, 0};
-                
-                BeginBlendMode(BLEND_ADDITIVE);
-                
-                Color vibrant_color = {tint_color.r, tint_color.g, tint_color.b, 
-                                      (unsigned char)(effect.alpha * 180)};
-                DrawTexturePro(texture, source, dest, origin, 0.0f, vibrant_color);
-                
-                EndBlendMode();
-                
-                BeginBlendMode(BLEND_ALPHA);
-                Color solid_color = {tint_color.r, tint_color.g, tint_color.b, 
-                                    (unsigned char)(effect.alpha * 255)};
-                DrawTexturePro(texture, source, dest, origin, 0.0f, solid_color);
-                EndBlendMode();
-            }
-        } else {
-            Color circle_color = {tint_color.r, tint_color.g, tint_color.b, (unsigned char)(effect.alpha * 200)};
-            DrawCircle(effect.x, effect.y, 30 * effect.scale, circle_color);
+            Color vibrant_color = {draw.tint.r, draw.tint.g, draw.tint.b, 
+                                  (unsigned char)(draw.alpha * 180)};
+            DrawTexturePro(texture, source, dest, origin, draw.rotation, vibrant_color);
+            
+            EndBlendMode();
         }
         
-        DrawTextEx(font, effect.key_text.c_str(), 
-                  {effect.x - text_size.x / 2, effect.y - text_size.y / 2},
-                  font_size, 2, text_color);
+        BeginBlendMode(BLEND_ALPHA);
+        Color solid_color = {draw.tint.r, draw.tint.g, draw.tint.b, 
+                            (unsigned char)(draw.alpha * 255)};
+        DrawTexturePro(texture, source, dest, origin, draw.rotation, solid_color);
+        EndBlendMode();
     }
     
+    static Rectangle merge_rects(Rectangle a, Rectangle b) {
+        if (a.width <= 0.0f || a.height <= 0.0f) return b;
+        if (b.width <= 0.0f || b.height <= 0.0f) return a;
+        float x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+        float x1 = std::max(a.x + a.width, b.x + b.width), y1 = std::max(a.y + a.height, b.y + b.height);
+        return {x0, y0, x1 - x0, y1 - y0};
+    }
+    
+    // a box of width x height around center, rotated ones by their diagonal.
+    // a couple of pixels of slack for filtering and glyph overhang
+    void add_drawn(Vector2 center, float width, float height, float rotation) {
+        if (rotation != 0.0f) {
+            width = height = std::sqrt(width * width + height * height);
+        }
+        drawn_bounds = merge_rects(drawn_bounds, {center.x - width / 2 - 2.0f, center.y - height / 2 - 2.0f, width + 4.0f, height + 4.0f});
+    }
+    
+    const Font& label_font() const {
+        return glyph_atlas.is_loaded() ? glyph_atlas.get_font() : font;
+    }
+    
+    static constexpr float GLOW_STRENGTH = 180.0f / 255.0f;
+    
     int width, height;
+    std::vector<OutputRegion> outputs;
     Font font;
     bool custom_font_loaded = false;
+    std::vector<std::string> fallback_fonts;
+    int glyph_size = 64;
+    GlyphAtlas glyph_atlas;
+    uint64_t render_frame = 0;
+    Rectangle drawn_bounds = {0, 0, 0, 0};
+    Rectangle previous_bounds = {0, 0, 0, 0};
     Color tint_color;
+    ColorizeConfig colorize;
+    ColorizeShader colorize_shader;
+    std::map<int, Color> key_colors;
     std::vector<AnimatedTexture> textures;
-    std::vector<KeyEffect> active_effects;
+    std::vector<ParticleEmitter> emitters;
+    std::mutex spawn_mutex; // emitter rings and the random placement, shared with the input thread
+    PlacementConfig placement;
+    EffectPlacer placer;
+    std::vector<uint32_t> released_placements;
+    EffectSimulation simulation;
+    EffectSnapshot previous_snapshot;
+    EffectSnapshot current_snapshot;
+    std::chrono::steady_clock::time_point last_frame;
+    QualityController quality;
+    float animation_delta = 0.0f;
+    unsigned int animation_frame = 0;
+    std::vector<EffectDraw> draw_list;
+    bool late_latch = false;
+    std::vector<KeyEffect> late_spawns;
+    uint32_t last_drawn_id = 0;
+    std::vector<std::chrono::steady_clock::time_point> unpresented_spawns;
+    LatencyHistogram present_latency;
 };
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <raylib.h>
+
+// device side of the cache, swapped out when there is no audio device
+struct SampleBackend {
+    // converts to the device format once, the mixer then plays it as is
+    std::function<Sound(const Wave&)> upload = [](const Wave& wave) { return LoadSoundFromWave(wave); };
+    std::function<Sound(const Sound&)> alias = [](const Sound& source) { return LoadSoundAlias(source); };
+    std::function<void(Sound&)> unload_alias = [](Sound& sound) { UnloadSoundAlias(sound); };
+    std::function<void(Sound&)> unload = [](Sound& sound) { UnloadSound(sound); };
+};
+
+struct SampleCacheStats {
+    size_t files = 0;           // load() calls that succeeded
+    size_t unique = 0;          // decoded samples
+    size_t stored_bytes = 0;    // device format bytes actually held
+    size_t saved_bytes = 0;     // bytes duplicates would have taken
+};
+
+// samples are keyed by a hash of the file contents, so every key pointing at
+// the same data (even under different paths) shares one decoded copy. a hit
+// also has to match the size and a second hash
+class SampleCache {
+public:
+    using Hash = uint64_t (*)(const unsigned char* data, size_t size);
+
+    // key picks the bucket, a test passes a weak one to force collisions
+    explicit SampleCache(SampleBackend b = {}, Hash key = hash_bytes) : backend(std::move(b)), key_hash(key) {}
+
+    SampleCache(const SampleCache&) = delete;
+    SampleCache& operator=(const SampleCache&) = delete;
+
+    ~SampleCache() {
+        clear();
+    }
+
+    static uint64_t hash_bytes(const unsigned char* data, size_t size) {
+        // fnv-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash ^ size;
+    }
+
+    // a second, unrelated hash, so an fnv-1a collision between two files of
+    // the same size still doesn't share a sample
+    static uint64_t check_bytes(const unsigned char* data, size_t size) {
+        uint64_t hash = 0x9E3779B97F4A7C15ull;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    // returns an alias with its own playback state, frameCount is 0 on failure
+    Sound load(const std::string& path) {
+        int size = 0;
+        unsigned char* data = LoadFileData(path.c_str(), &size);
+        if (data == nullptr || size <= 0) {
+            if (data) UnloadFileData(data);
+            return Sound{};
+        }
+
+        Sound sound = load_from_memory(GetFileExtension(path.c_str()), data, size);
+        UnloadFileData(data);
+        return sound;
+    }
+
+    // file_type is the extension with the dot, like LoadWaveFromMemory wants
+    Sound load_from_memory(const char* file_type, const unsigned char* data, int size) {
+        uint64_t hash = key_hash(data, (size_t)size);
+        uint64_t check = check_bytes(data, (size_t)size);
+
+        auto it = samples.end();
+        auto [first, last] = samples.equal_range(hash);
+        for (auto candidate = first; candidate != last; ++candidate) {
+            if (candidate->second.file_size == (size_t)size && candidate->second.check == check) {
+                it = candidate;
+                break;
+            }
+        }
+        bool shared = it != samples.end();
+        if (!shared) {
+            Wave wave = LoadWaveFromMemory(file_type, data, size);
+            if (wave.frameCount == 0) {
+                UnloadWave(wave);
+                return Sound{};
+            }
+
+            Sound source = backend.upload(wave);
+            UnloadWave(wave);
+            if (source.frameCount == 0) {
+                return Sound{};
+            }
+
+            it = samples.emplace(hash, Sample{source, device_bytes(source), (size_t)size, check});
+            stats.unique++;
+            stats.stored_bytes += it->second.bytes;
+        }
+
+        Sound alias = backend.alias(it->second.source);
+        if (alias.frameCount == 0) {
+            return Sound{};
+        }
+
+        aliases.push_back(alias);
+        stats.files++;
+        if (shared) {
+            stats.saved_bytes += it->second.bytes;
+        }
+        return alias;
+    }
+
+    const SampleCacheStats& get_stats() const {
+        return stats;
+    }
+
+    void clear() {
+        // aliases reference the source buffers, they go first
+        for (Sound& alias : aliases) {
+            backend.unload_alias(alias);
+        }
+        aliases.clear();
+
+        for (auto& [hash, sample] : samples) {
+            backend.unload(sample.source);
+        }
+        samples.clear();
+        stats = {};
+    }
+
+private:
+    struct Sample {
+        Sound source;
+        size_t bytes;
+        size_t file_size;   // with check, tells fnv-1a collisions apart
+        uint64_t check;
+    };
+
+    static size_t device_bytes(const Sound& sound) {
+        return (size_t)sound.frameCount * sound.stream.channels * (sound.stream.sampleSize / 8);
+    }
+
+    SampleBackend backend;
+    Hash key_hash;
+    std::unordered_multimap<uint64_t, Sample> samples;
+    std::vector<Sound> aliases;
+    SampleCacheStats stats;
+};
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include <functional>
+#include <utility>
+#include <raylib.h>
+#include "triple_buffer.h"
+#include "effect_budget.h"
+#include "effect_curves.h"
+
+struct KeyEffect {
+    uint32_t id;
+    int key_code;
+    int output;
+    std::string key_text;
+    float x, y;
+    CurvePose pose;
+    int curve;              // index into the simulation's curves, picked from key_code on spawn
+    float base_scale;
+    float intensity;
+    Color tint;
+    std::chrono::steady_clock::time_point start_time;
+    int texture_index;
+    uint32_t placement;     // the placer's ticket for the effect's cell
+    bool active;
+};
+
+// the live effect a press coalesces into
+struct CoalesceTarget {
+    uint32_t id = 0;
+    float x = 0.0f, y = 0.0f;
+};
+
+// immutable once published, effects are ordered by id
+struct EffectSnapshot {
+    std::chrono::steady_clock::time_point time;
+    uint64_t tick = 0;
+    uint32_t last_spawn_id = 0;
+    std::vector<KeyEffect> effects;
+};
+
+class EffectSimulation {
+public:
+    using clock = std::chrono::steady_clock;
+    
+    EffectSimulation() = default;
+    
+    EffectSimulation(const EffectSimulation&) = delete;
+    EffectSimulation& operator=(const EffectSimulation&) = delete;
+    
+    ~EffectSimulation() {
+        stop();
+    }
+    
+    // before start()
+    void set_budget(const EffectBudgetConfig& config) {
+        budget = config;
+        if (budget.max_effects < 1) budget.max_effects = 1;
+        if (budget.max_intensity < 1) budget.max_intensity = 1;
+    }
+    
+    void start(int tick_rate) {
+        if (worker.joinable()) return;
+        
+        if (tick_rate < 1) tick_rate = 1;
+        tick_duration = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / tick_rate));
+        
+        running = true;
+        worker = std::thread(&EffectSimulation::run, this);
+    }
+    
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(pending_mutex);
+            running = false;
+        }
+        wake.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    
+    // before start(). curves[0] is the default, key_curves maps a vk to its curve
+    void set_curves(std::vector<EffectCurve> effect_curves, const std::vector<int>& key_curves) {
+        curves = std::move(effect_curves);
+        if (curves.empty()) {
+            curves.emplace_back();
+        }
+        
+        lifetime = 0.0f;
+        for (const EffectCurve& curve : curves) {
+            lifetime = std::max(lifetime, curve.get_duration());
+        }
+        
+        for (int vk = 0; vk < 256; vk++) {
+            int index = vk < (int)key_curves.size() ? key_curves[vk] : 0;
+            curve_for_key[vk] = index >= 0 && index < (int)curves.size() ? index : 0;
+        }
+    }
+    
+    // any thread, picked up on the next tick
+    void spawn(KeyEffect effect) {
+        // spawn state right away, late latched frames draw it before the first tick
+        effect.curve = curve_for_key[effect.key_code & 0xFF];
+        curves[effect.curve].start(effect.pose);
+        
+        {
+            std::lock_guard<std::mutex> lk(pending_mutex);
+            
+            // a storm between two ticks must not queue without bound either
+            if ((int)pending.size() >= budget.max_effects) {
+                forget(pending.front());
+                pending.erase(pending.begin());
+                shed_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            
+            effect.id = next_id++;
+            last_spawn_for_key[key_slot(effect)] = {effect.id, effect.x, effect.y, effect.placement, effect.start_time};
+            pending.push_back(std::move(effect));
+        }
+        wake.notify_one();
+    }
+    
+    // any thread, decided right away so the caller knows where the press
+    // shows up. true when the key's last effect is still within the coalesce
+    // window, that effect then restarts a bit stronger on the next tick
+    // instead of a new one spawning. renew_placement gets the effect's
+    // placement ticket, under the simulation's lock, and returns its new one
+    bool coalesce(int output, int key_code, clock::time_point time, CoalesceTarget& target,
+                  const std::function<uint32_t(uint32_t)>& renew_placement) {
+        if (budget.coalesce_window <= 0.0f) return false;
+        
+        std::unique_lock<std::mutex> lk(pending_mutex);
+        auto last = last_spawn_for_key.find(key_slot(output, key_code));
+        if (last == last_spawn_for_key.end()) return false;
+        
+        // the effect has to still be on screen too, it lives one curve duration from its last restart
+        float elapsed = std::chrono::duration<float>(time - last->second.start_time).count();
+        float duration = curves[curve_for_key[key_code & 0xFF]].get_duration();
+        if (elapsed < 0.0f || elapsed >= budget.coalesce_window || elapsed >= duration) return false;
+        
+        last->second.start_time = time;
+        last->second.placement = renew_placement(last->second.placement);
+        pending_coalesces.push_back({last->second.id, time, last->second.placement});
+        coalesced_count.fetch_add(1, std::memory_order_relaxed);
+        target = {last->second.id, last->second.x, last->second.y};
+        lk.unlock();
+        wake.notify_one();
+        return true;
+    }
+    
+    // placement tickets of effects gone before the placer's lifetime since the last call, any thread
+    void take_released_placements(std::vector<uint32_t>& out) {
+        std::lock_guard<std::mutex> lk(pending_mutex);
+        out.swap(released_placements);
+        released_placements.clear();
+    }
+    
+    // spawns newer than after_id that no snapshot has carried yet, lets the
+    // renderer show a press that arrived after the last tick
+    void collect_unpublished(uint32_t after_id, std::vector<KeyEffect>& out) {
+        std::lock_guard<std::mutex> lk(pending_mutex);
+        for (const auto& [tick, effect] : recent) {
+            if (effect.id > after_id) out.push_back(effect);
+        }
+        for (const auto& effect : pending) {
+            if (effect.id > after_id) out.push_back(effect);
+        }
+    }
+    
+    // render thread, true when latest() changed since the last call
+    bool acquire() {
+        return snapshots.acquire();
+    }
+    
+    const EffectSnapshot& latest() const {
+        return snapshots.read_buffer();
+    }
+    
+    // seconds from spawn until the longest lived effect is gone
+    float get_effect_lifetime() const {
+        return lifetime;
+    }
+    
+    clock::duration get_tick_duration() const {
+        return tick_duration;
+    }
+    
+    uint64_t get_tick_count() const {
+        return tick_count.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t get_coalesced_count() const {
+        return coalesced_count.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t get_shed_count() const {
+        return shed_count.load(std::memory_order_relaxed);
+    }
+    
+    double get_average_step_us() const {
+        uint64_t ticks = get_tick_count();
+        if (ticks == 0) return 0.0;
+        return step_time_ns.load(std::memory_order_relaxed) / 1000.0 / ticks;
+    }
+    
+    // any thread, a tick finishing meanwhile may land on either side of the reset
+    void reset_counters() {
+        tick_count.store(0, std::memory_order_relaxed);
+        step_time_ns.store(0, std::memory_order_relaxed);
+        coalesced_count.store(0, std::memory_order_relaxed);
+        shed_count.store(0, std::memory_order_relaxed);
+    }
+    
+private:
+    static constexpr int MAX_CATCHUP_STEPS = 8;
+    static constexpr uint64_t RECENT_TICKS = 8;
+    
+    void run() {
+        auto next_tick = clock::now();
+        bool published_empty = false;
+        
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lk(pending_mutex);
+                if (effects.empty() && pending.empty() && pending_coalesces.empty() && published_empty) {
+                    // nothing on screen, sleep until a press instead of ticking
+                    wake.wait(lk, [&] { return !running || !pending.empty() || !pending_coalesces.empty(); });
+                    next_tick = clock::now();
+                } else {
+                    // raylib raises the timer resolution to 1 ms, a tick woken a
+                    // little late is made up by the fixed steps below
+                    wake.wait_until(lk, next_tick, [&] { return !running; });
+                }
+                if (!running) break;
+            }
+            
+            auto now = clock::now();
+            
+            // fixed steps to catch up after a stall, bounded so we never spiral
+            int steps = 0;
+            while (next_tick <= now && steps < MAX_CATCHUP_STEPS) {
+                step(next_tick);
+                next_tick += tick_duration;
+                steps++;
+            }
+            if (next_tick <= now) {
+                next_tick = now + tick_duration;
+            }
+            
+            // an empty snapshot goes out once so the last effects disappear
+            if (!effects.empty() || !published_empty) {
+                publish();
+                published_empty = effects.empty();
+            }
+            
+            step_time_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - now).count(),
+                                   std::memory_order_relaxed);
+            tick_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    
+    void step(clock::time_point time) {
+        {
+            std::lock_guard<std::mutex> lk(pending_mutex);
+            
+            // consumed spawns stay visible to collect_unpublished() until a snapshot surely has them
+            while (!recent.empty() && sim_tick - recent.front().first > RECENT_TICKS) {
+                recent.erase(recent.begin());
+            }
+            for (auto& effect : pending) {
+                recent.emplace_back(sim_tick, effect);
+                last_spawn_id = effect.id;
+                admit(std::move(effect));
+            }
+            pending.clear();
+            
+            // after the spawns, a press may coalesce into an effect from this same batch
+            for (const PendingCoalesce& coalesced : pending_coalesces) {
+                KeyEffect* previous = find_effect(coalesced.id);
+                if (!previous) continue;    // shed meanwhile
+                previous->start_time = coalesced.time;
+                previous->placement = coalesced.placement;
+                previous->intensity = std::min(previous->intensity + 1.0f, (float)budget.max_intensity);
+            }
+            pending_coalesces.clear();
+        }
+        
+        for (auto it = effects.begin(); it != effects.end();) {
+            KeyEffect& effect = *it;
+            
+            float elapsed = std::chrono::duration<float>(time - effect.start_time).count();
+            if (elapsed < 0.0f) elapsed = 0.0f;
+            
+            if (!curves[effect.curve].evaluate(elapsed, effect.pose)) {
+                // the placer holds cells for the longest curve, a shorter one hands its cell back
+                if (curves[effect.curve].get_duration() < lifetime) {
+                    std::lock_guard<std::mutex> lk(pending_mutex);
+                    forget(effect);
+                }
+                it = effects.erase(it);
+                continue;
+            }
+            
+            ++it;
+        }
+        
+        sim_time = time;
+        sim_tick++;
+    }
+    
+    // pending_mutex held
+    void admit(KeyEffect&& effect) {
+        if ((int)effects.size() >= budget.max_effects) {
+            forget(effects.front());
+            effects.erase(effects.begin());
+            shed_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        effects.push_back(std::move(effect));
+    }
+    
+    // pending_mutex held, a shed or early expired effect can't take presses
+    // anymore and its cell goes back to the placer
+    void forget(const KeyEffect& effect) {
+        // a coalesce not applied yet may have moved the effect's placement, the record has the latest
+        auto last = last_spawn_for_key.find(key_slot(effect));
+        if (last != last_spawn_for_key.end() && last->second.id == effect.id) {
+            released_placements.push_back(last->second.placement);
+            last_spawn_for_key.erase(last);
+        } else {
+            released_placements.push_back(effect.placement);
+        }
+    }
+    
+    static uint32_t key_slot(int output, int key_code) {
+        return ((uint32_t)output << 16) | ((uint32_t)key_code & 0xFFFF);
+    }
+    
+    static uint32_t key_slot(const KeyEffect& effect) {
+        return key_slot(effect.output, effect.key_code);
+    }
+    
+    KeyEffect* find_effect(uint32_t id) {
+        auto it = std::lower_bound(effects.begin(), effects.end(), id,
+                                   [](const KeyEffect& effect, uint32_t value) { return effect.id < value; });
+        return (it != effects.end() && it->id == id) ? &*it : nullptr;
+    }
+    
+    void publish() {
+        EffectSnapshot& snapshot = snapshots.write_buffer();
+        snapshot.time = sim_time;
+        snapshot.tick = sim_tick;
+        snapshot.last_spawn_id = last_spawn_id;
+        snapshot.effects.assign(effects.begin(), effects.end());
+        snapshots.publish();
+    }
+    
+    EffectBudgetConfig budget;
+    std::vector<EffectCurve> curves = std::vector<EffectCurve>(1);
+    int curve_for_key[256] = {};
+    float lifetime = 1.0f;
+    clock::duration tick_duration = std::chrono::milliseconds(8);
+    std::thread worker;
+    std::atomic<bool> running{false};
+    
+    struct LastSpawn {
+        uint32_t id;
+        float x, y;
+        uint32_t placement;
+        clock::time_point start_time;   // moves with every coalesced press
+    };
+    
+    struct PendingCoalesce {
+        uint32_t id;
+        clock::time_point time;
+        uint32_t placement;
+    };
+    
+    std::mutex pending_mutex;
+    std::condition_variable wake;       // spawn, coalesce and stop() wake the thread early
+    std::vector<KeyEffect> pending;
+    std::vector<PendingCoalesce> pending_coalesces;
+    std::unordered_map<uint32_t, LastSpawn> last_spawn_for_key;
+    std::vector<uint32_t> released_placements;
+    std::vector<std::pair<uint64_t, KeyEffect>> recent;
+    uint32_t next_id = 1;
+    
+    // owned by the simulation thread
+    std::vector<KeyEffect> effects;
+    uint32_t last_spawn_id = 0;
+    clock::time_point sim_time;
+    uint64_t sim_tick = 0;
+    
+    TripleBuffer<EffectSnapshot> snapshots;
+    std::atomic<uint64_t> tick_count{0};
+    std::atomic<uint64_t> step_time_ns{0};
+    std::atomic<uint64_t> coalesced_count{0};
+    std::atomic<uint64_t> shed_count{0};
+};
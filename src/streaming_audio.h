@@ -0,0 +1,368 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <condition_variable>
+#include <raylib.h>
+#include "definitions.h"
+
+struct StreamingConfig {
+    int threshold_kb = 512;     // files bigger than this are streamed instead of decoded up front
+    int head_ms = 150;          // decoded ahead on every idle voice, covers the attack
+    int memory_kb = 4096;       // hard cap for all streamed voices together
+    int max_voices = 8;         // overlapping plays per sound
+
+    // GetFileLength is an int, no file past this is measured anyway
+    static constexpr int MAX_KB = 2 * 1024 * 1024 - 1;
+};
+
+// read only view of a whole file, pages are loaded by the os as the decoder touches them
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            file = nullptr;
+            return false;
+        }
+
+        DWORD high = 0;
+        DWORD low = GetFileSize(file, &high);
+        if (high != 0 || low == 0 || low > 0x7FFFFFFF) {
+            // raylib takes an int size
+            close();
+            return false;
+        }
+        size = (int)low;
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (!data) {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void close() {
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file) CloseHandle(file);
+        data = nullptr;
+        mapping = file = nullptr;
+        size = 0;
+    }
+
+    const unsigned char* get_data() const {
+        return data;
+    }
+
+    int get_size() const {
+        return size;
+    }
+
+private:
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+    const unsigned char* data = nullptr;
+    int size = 0;
+};
+
+class SoundStreamer;
+
+class StreamedSound {
+    friend class SoundStreamer;
+
+    // PRIMED voices belong to play(), PLAYING and RESTART ones to the decoder thread
+    enum VoiceState : int {
+        PRIMED,
+        STARTING,
+        PLAYING,
+        RESTART
+    };
+
+    struct Voice {
+        Music music = {};
+        std::atomic<int> state{PRIMED};
+        std::atomic<float> volume{1.0f};
+        std::atomic<unsigned long long> started{0};
+    };
+
+    std::string path;
+    MappedFile file;
+    int head_frames = 0;
+    size_t voice_bytes = 0;
+    std::vector<std::unique_ptr<Voice>> voices;
+};
+
+// long sounds play through a pool of primed music streams over a memory
+// mapped file. an idle voice already holds its first head_ms decoded, so
+// play() starts it right away and the decoder thread streams the rest
+class SoundStreamer {
+public:
+    SoundStreamer() = default;
+
+    SoundStreamer(const SoundStreamer&) = delete;
+    SoundStreamer& operator=(const SoundStreamer&) = delete;
+
+    ~SoundStreamer() {
+        unload();
+    }
+
+    void set_config(const StreamingConfig& cfg) {
+        config = cfg;
+        config.threshold_kb = std::clamp(config.threshold_kb, 0, StreamingConfig::MAX_KB);
+        config.memory_kb = std::clamp(config.memory_kb, 0, StreamingConfig::MAX_KB);
+        if (config.head_ms < 40) config.head_ms = 40;
+        if (config.max_voices < 1) config.max_voices = 1;
+    }
+
+    bool should_stream(const std::string& path) const {
+        return (int64_t)GetFileLength(path.c_str()) > (int64_t)config.threshold_kb * 1024;
+    }
+
+    // one voice up front, start() hands out the rest of the budget.
+    // nullptr means the caller should load the sound normally
+    StreamedSound* load(const std::string& path) {
+        for (auto& sound : sounds) {
+            if (sound->path == path) return sound.get();
+        }
+
+        auto sound = std::make_unique<StreamedSound>();
+        sound->path = path;
+        if (!sound->file.open(path)) {
+            std::cout << "Warning: Could not map " << path << " for streaming\n";
+            return nullptr;
+        }
+
+        // the stream keeps the file's rate, probe it once to size the head
+        Music probe = LoadMusicStreamFromMemory(GetFileExtension(path.c_str()), sound->file.get_data(), sound->file.get_size());
+        if (!IsMusicValid(probe)) {
+            std::cout << "Warning: Could not decode " << path << " for streaming\n";
+            return nullptr;
+        }
+        sound->head_frames = (int)(probe.stream.sampleRate * config.head_ms / 1000);
+        UnloadMusicStream(probe);
+
+        if (!add_voice(*sound)) {
+            std::cout << "Warning: Streaming budget too small for " << path << "\n";
+            return nullptr;
+        }
+
+        sounds.push_back(std::move(sound));
+        return sounds.back().get();
+    }
+
+    // fills the remaining budget round robin and starts the decoder thread
+    void start() {
+        bool added = true;
+        while (added) {
+            added = false;
+            for (auto& sound : sounds) {
+                if ((int)sound->voices.size() < config.max_voices && add_voice(*sound)) {
+                    added = true;
+                }
+            }
+        }
+
+        if (sounds.empty() || running) return;
+        running = true;
+        decoder = std::thread(&SoundStreamer::run, this);
+    }
+
+    // any thread, never decodes
+    void play(StreamedSound* sound, float volume) {
+        unsigned long long serial = ++play_serial;
+
+        for (auto& voice : sound->voices) {
+            int primed = StreamedSound::PRIMED;
+            if (voice->state.compare_exchange_strong(primed, StreamedSound::STARTING)) {
+                voice->started = serial;
+                SetMusicVolume(voice->music, volume);
+                PlayMusicStream(voice->music);
+                voice->state = StreamedSound::PLAYING;
+                return;
+            }
+        }
+
+        // every voice is busy, the decoder restarts the oldest one
+        StreamedSound::Voice* oldest = nullptr;
+        for (auto& voice : sound->voices) {
+            if (voice->state == StreamedSound::PLAYING && (!oldest || voice->started < oldest->started)) {
+                oldest = voice.get();
+            }
+        }
+
+        int playing = StreamedSound::PLAYING;
+        if (oldest && oldest->state.compare_exchange_strong(playing, StreamedSound::RESTART)) {
+            oldest->started = serial;
+            oldest->volume = volume;
+            steal_count++;
+            wake.notify_one();
+        } else {
+            drop_count++;
+        }
+    }
+
+    void stop() {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            running = false;
+        }
+        wake.notify_one();
+        if (decoder.joinable()) {
+            decoder.join();
+        }
+    }
+
+    // needs the audio device, call before CloseAudioDevice
+    void unload() {
+        stop();
+        for (auto& sound : sounds) {
+            for (auto& voice : sound->voices) {
+                UnloadMusicStream(voice->music);
+            }
+        }
+        sounds.clear();
+        memory_bytes = 0;
+    }
+
+    size_t get_voice_count() const {
+        size_t count = 0;
+        for (const auto& sound : sounds) {
+            count += sound->voices.size();
+        }
+        return count;
+    }
+
+    size_t get_memory_bytes() const {
+        return memory_bytes;
+    }
+
+    unsigned long long get_steal_count() const {
+        return steal_count.load();
+    }
+
+    unsigned long long get_drop_count() const {
+        return drop_count.load();
+    }
+
+    // voices the decoder is feeding right now
+    size_t get_playing_count() const {
+        size_t count = 0;
+        for (const auto& sound : sounds) {
+            for (const auto& voice : sound->voices) {
+                if (voice->state != StreamedSound::PRIMED) count++;
+            }
+        }
+        return count;
+    }
+
+    void reset_counters() {
+        steal_count = 0;
+        drop_count = 0;
+    }
+
+private:
+    // rough decoder state per voice, stb_vorbis is the heaviest of raylib's decoders
+    static constexpr size_t DECODER_BYTES = 64 * 1024;
+    static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(5);
+
+    bool add_voice(StreamedSound& sound) {
+        // the head is split over the stream's two sub buffers
+        SetAudioStreamBufferSizeDefault(sound.head_frames / 2);
+        Music music = LoadMusicStreamFromMemory(GetFileExtension(sound.path.c_str()), sound.file.get_data(), sound.file.get_size());
+        SetAudioStreamBufferSizeDefault(0);
+        if (!IsMusicValid(music)) {
+            return false;
+        }
+
+        size_t bytes = (size_t)sound.head_frames * music.stream.channels * (music.stream.sampleSize / 8) + DECODER_BYTES;
+        if (memory_bytes + bytes > (size_t)config.memory_kb * 1024) {
+            UnloadMusicStream(music);
+            return false;
+        }
+
+        music.looping = false;
+        auto voice = std::make_unique<StreamedSound::Voice>();
+        voice->music = music;
+        prime(*voice);
+
+        sound.voice_bytes = bytes;
+        sound.voices.push_back(std::move(voice));
+        memory_bytes += bytes;
+        return true;
+    }
+
+    static void prime(StreamedSound::Voice& voice) {
+        for (int i = 0; i < 2 && IsAudioStreamProcessed(voice.music.stream); i++) {
+            UpdateMusicStream(voice.music);
+        }
+    }
+
+    void run() {
+        while (running) {
+            for (auto& sound : sounds) {
+                for (auto& voice : sound->voices) {
+                    int state = voice->state.load();
+
+                    if (state == StreamedSound::RESTART) {
+                        StopMusicStream(voice->music);
+                        prime(*voice);
+                        SetMusicVolume(voice->music, voice->volume);
+                        PlayMusicStream(voice->music);
+                        voice->state = StreamedSound::PLAYING;
+                    } else if (state == StreamedSound::PLAYING) {
+                        if (IsMusicStreamPlaying(voice->music)) {
+                            UpdateMusicStream(voice->music);
+                            continue;
+                        }
+
+                        // finished, stopping rewinds the decoder. if play() stole
+                        // it meanwhile the next pass restarts it
+                        StopMusicStream(voice->music);
+                        prime(*voice);
+                        voice->state.compare_exchange_strong(state, StreamedSound::PRIMED);
+                    }
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, POLL_INTERVAL);
+        }
+    }
+
+    StreamingConfig config;
+    std::vector<std::unique_ptr<StreamedSound>> sounds;
+    size_t memory_bytes = 0;
+
+    std::thread decoder;
+    std::atomic<bool> running{false};
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+    std::atomic<unsigned long long> play_serial{0};
+    std::atomic<unsigned long long> steal_count{0};
+    std::atomic<unsigned long long> drop_count{0};
+};
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include <raylib.h>
+
+enum class TextureStorage {
+    RGBA,       // uncompressed R8G8B8A8
+    DXT,        // BC3/DXT5 block compressed, 1 byte per pixel
+    PALETTE     // 8-bit indices + 256 entry palette looked up in the shader
+};
+
+namespace texture_codec {
+
+inline uint16_t pack_565(int r, int g, int b) {
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+inline void unpack_565(uint16_t c, int rgb[3]) {
+    rgb[0] = ((c >> 11) & 0x1F) * 255 / 31;
+    rgb[1] = ((c >> 5) & 0x3F) * 255 / 63;
+    rgb[2] = (c & 0x1F) * 255 / 31;
+}
+
+// bounding box endpoints, no refinement. good enough for small effect sprites
+// and fast enough to run at load time
+inline void encode_dxt5_block(const Color block[16], uint8_t out[16]) {
+    // alpha, 8 interpolated values between max and min
+    int a_max = 0, a_min = 255;
+    for (int i = 0; i < 16; i++) {
+        a_max = std::max(a_max, (int)block[i].a);
+        a_min = std::min(a_min, (int)block[i].a);
+    }
+
+    int alphas[8] = {a_max, a_min};
+    for (int i = 1; i < 7; i++) {
+        alphas[i + 1] = ((7 - i) * a_max + i * a_min) / 7;
+    }
+
+    uint64_t alpha_bits = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, best_error = 256;
+        for (int j = 0; j < 8; j++) {
+            int error = std::abs(alphas[j] - block[i].a);
+            if (error < best_error) {
+                best = j;
+                best_error = error;
+            }
+        }
+        alpha_bits |= (uint64_t)best << (3 * i);
+    }
+
+    out[0] = (uint8_t)a_max;
+    out[1] = (uint8_t)a_min;
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (uint8_t)(alpha_bits >> (8 * i));
+    }
+
+    // color, bc3 always decodes the color block in 4 color mode
+    int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        if (block[i].a == 0) continue;
+        const unsigned char rgb[3] = {block[i].r, block[i].g, block[i].b};
+        for (int c = 0; c < 3; c++) {
+            lo[c] = std::min(lo[c], (int)rgb[c]);
+            hi[c] = std::max(hi[c], (int)rgb[c]);
+        }
+    }
+    if (lo[0] > hi[0]) {
+        lo[0] = lo[1] = lo[2] = hi[0] = hi[1] = hi[2] = 0;
+    }
+
+    uint16_t c0 = pack_565(hi[0], hi[1], hi[2]);
+    uint16_t c1 = pack_565(lo[0], lo[1], lo[2]);
+
+    int palette[4][3];
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t color_bits = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, best_error = 1 << 30;
+        for (int j = 0; j < 4; j++) {
+            int dr = palette[j][0] - block[i].r;
+            int dg = palette[j][1] - block[i].g;
+            int db = palette[j][2] - block[i].b;
+            int error = dr * dr + dg * dg + db * db;
+            if (error < best_error) {
+                best = j;
+                best_error = error;
+            }
+        }
+        color_bits |= (uint32_t)best << (2 * i);
+    }
+
+    out[8] = (uint8_t)(c0 & 0xFF);
+    out[9] = (uint8_t)(c0 >> 8);
+    out[10] = (uint8_t)(c1 & 0xFF);
+    out[11] = (uint8_t)(c1 >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[12 + i] = (uint8_t)(color_bits >> (8 * i));
+    }
+}
+
+// width and height must be multiples of 4, returned buffer is MemAlloc'd so
+// raylib can own it as image data
+inline unsigned char* encode_dxt5(const Color* pixels, int width, int height) {
+    unsigned char* out = (unsigned char*)MemAlloc(width * height);
+    Color block[16];
+
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    block[y * 4 + x] = pixels[(by + y) * width + bx + x];
+                }
+            }
+            encode_dxt5_block(block, out + ((by / 4) * (width / 4) + bx / 4) * 16);
+        }
+    }
+
+    return out;
+}
+
+// median cut over every frame so the whole animation shares one palette,
+// index 0 is reserved for fully transparent pixels
+inline std::vector<Color> build_palette(const std::vector<const Color*>& frames, int pixel_count) {
+    struct Box {
+        size_t begin, end;
+    };
+
+    std::vector<Color> samples;
+    samples.reserve(frames.size() * pixel_count);
+    for (const Color* frame : frames) {
+        for (int i = 0; i < pixel_count; i++) {
+            if (frame[i].a > 0) samples.push_back(frame[i]);
+        }
+    }
+
+    std::vector<Color> palette = {{0, 0, 0, 0}};
+    if (samples.empty()) {
+        return palette;
+    }
+
+    auto channel = [](const Color& c, int i) {
+        return i == 0 ? c.r : i == 1 ? c.g : i == 2 ? c.b : c.a;
+    };
+
+    auto widest = [&](const Box& box, int& range) {
+        int lo[4] = {255, 255, 255, 255}, hi[4] = {0, 0, 0, 0};
+        for (size_t i = box.begin; i < box.end; i++) {
+            for (int c = 0; c < 4; c++) {
+                lo[c] = std::min(lo[c], (int)channel(samples[i], c));
+                hi[c] = std::max(hi[c], (int)channel(samples[i], c));
+            }
+        }
+        int best = 0;
+        range = -1;
+        for (int c = 0; c < 4; c++) {
+            if (hi[c] - lo[c] > range) {
+                range = hi[c] - lo[c];
+                best = c;
+            }
+        }
+        return best;
+    };
+
+    std::vector<Box> boxes = {{0, samples.size()}};
+    while (boxes.size() < 255) {
+        size_t split = boxes.size();
+        int split_channel = 0, split_range = 0;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            if (boxes[i].end - boxes[i].begin < 2) continue;
+            int range;
+            int c = widest(boxes[i], range);
+            if (range > split_range) {
+                split = i;
+                split_channel = c;
+                split_range = range;
+            }
+        }
+        if (split == boxes.size()) break;
+
+        Box box = boxes[split];
+        size_t middle = box.begin + (box.end - box.begin) / 2;
+        std::nth_element(samples.begin() + box.begin, samples.begin() + middle, samples.begin() + box.end,
+                         [&](const Color& a, const Color& b) { return channel(a, split_channel) < channel(b, split_channel); });
+        boxes[split] = {box.begin, middle};
+        boxes.push_back({middle, box.end});
+    }
+
+    for (const Box& box : boxes) {
+        uint64_t sum[4] = {0, 0, 0, 0};
+        for (size_t i = box.begin; i < box.end; i++) {
+            for (int c = 0; c < 4; c++) sum[c] += channel(samples[i], c);
+        }
+        size_t n = box.end - box.begin;
+        palette.push_back({(unsigned char)(sum[0] / n), (unsigned char)(sum[1] / n),
+                           (unsigned char)(sum[2] / n), (unsigned char)(sum[3] / n)});
+    }
+
+    return palette;
+}
+
+// MemAlloc'd index buffer, one byte per pixel
+inline unsigned char* map_to_palette(const Color* pixels, int pixel_count, const std::vector<Color>& palette) {
+    unsigned char* out = (unsigned char*)MemAlloc(pixel_count);
+    std::unordered_map<uint32_t, unsigned char> cache;
+
+    for (int i = 0; i < pixel_count; i++) {
+        const Color& p = pixels[i];
+        if (p.a == 0) {
+            out[i] = 0;
+            continue;
+        }
+
+        uint32_t key = ((uint32_t)p.r << 24) | ((uint32_t)p.g << 16) | ((uint32_t)p.b << 8) | p.a;
+        auto cached = cache.find(key);
+        if (cached != cache.end()) {
+            out[i] = cached->second;
+            continue;
+        }
+
+        int best = 1, best_error = 1 << 30;
+        for (size_t j = 1; j < palette.size(); j++) {
+            int dr = palette[j].r - p.r, dg = palette[j].g - p.g;
+            int db = palette[j].b - p.b, da = palette[j].a - p.a;
+            int error = dr * dr + dg * dg + db * db + da * da;
+            if (error < best_error) {
+                best = (int)j;
+                best_error = error;
+            }
+        }
+
+        out[i] = (unsigned char)best;
+        cache[key] = (unsigned char)best;
+    }
+
+    return out;
+}
+
+// area average for shrinking, straight into the destination. colors are
+// weighted by alpha so transparent pixels don't darken the edges
+inline void downscale_box(const Color* src, int src_w, int src_h, Color* dst, int dst_w, int dst_h) {
+    for (int dy = 0; dy < dst_h; dy++) {
+        int y0 = dy * src_h / dst_h;
+        int y1 = std::max((dy + 1) * src_h / dst_h, y0 + 1);
+        for (int dx = 0; dx < dst_w; dx++) {
+            int x0 = dx * src_w / dst_w;
+            int x1 = std::max((dx + 1) * src_w / dst_w, x0 + 1);
+
+            uint32_t r = 0, g = 0, b = 0, a = 0;
+            for (int y = y0; y < y1; y++) {
+                const Color* row = src + (size_t)y * src_w;
+                for (int x = x0; x < x1; x++) {
+                    r += row[x].r * row[x].a;
+                    g += row[x].g * row[x].a;
+                    b += row[x].b * row[x].a;
+                    a += row[x].a;
+                }
+            }
+
+            uint32_t count = (uint32_t)((y1 - y0) * (x1 - x0));
+            Color& out = dst[(size_t)dy * dst_w + dx];
+            if (a == 0) {
+                out = {0, 0, 0, 0};
+            } else {
+                out = {(unsigned char)(r / a), (unsigned char)(g / a), (unsigned char)(b / a), (unsigned char)(a / count)};
+            }
+        }
+    }
+}
+
+} // namespace texture_codec
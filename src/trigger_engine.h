@@ -0,0 +1,214 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+// chords and sequences are compiled once into lookup tables so a key press
+// costs the same no matter how many bindings there are:
+// - chords: one slot per (modifier mask, vk), 16 * 256 entries
+// - sequences: an aho-corasick automaton flattened into a dfa over the keys
+//   that appear in any sequence, every other key maps to symbol 0
+class TriggerEngine {
+public:
+    enum Modifier {
+        CTRL = 1,
+        ALT = 2,
+        SHIFT = 4,
+        WIN = 8
+    };
+
+    static constexpr int NO_ACTION = -1;
+
+    // modifier bit for a modifier vk, 0 for anything else
+    static int modifier_for_key(int vk) {
+        switch (vk) {
+            case 0x11: case 0xA2: case 0xA3: return CTRL;   // VK_CONTROL, VK_LCONTROL, VK_RCONTROL
+            case 0x12: case 0xA4: case 0xA5: return ALT;    // VK_MENU, VK_LMENU, VK_RMENU
+            case 0x10: case 0xA0: case 0xA1: return SHIFT;  // VK_SHIFT, VK_LSHIFT, VK_RSHIFT
+            case 0x5B: case 0x5C: return WIN;               // VK_LWIN, VK_RWIN
+            default: return 0;
+        }
+    }
+
+    // returns false when the chord was already bound, the new action wins
+    bool add_chord(int modifiers, int vk, int action) {
+        int& slot = chords[chord_index(modifiers, vk)];
+        bool fresh = slot == NO_ACTION;
+        slot = action;
+        return fresh;
+    }
+
+    void add_sequence(const std::vector<int>& keys, int action) {
+        if (!keys.empty()) {
+            sequences.push_back({keys, action});
+        }
+    }
+
+    // builds the sequence dfa, call after every add_sequence and before key_down
+    void compile() {
+        // compress the alphabet, symbol 0 is every key no sequence uses
+        symbol_count = 1;
+        for (int& symbol : symbols) symbol = 0;
+        for (const Sequence& sequence : sequences) {
+            for (int vk : sequence.keys) {
+                if (symbols[vk & 0xFF] == 0) symbols[vk & 0xFF] = symbol_count++;
+            }
+        }
+
+        // trie
+        std::vector<std::vector<int>> outputs(1);
+        transitions.assign(symbol_count, -1);
+        for (const Sequence& sequence : sequences) {
+            int state = 0;
+            for (int vk : sequence.keys) {
+                size_t edge = (size_t)state * symbol_count + symbols[vk & 0xFF];
+                if (transitions[edge] < 0) {
+                    transitions[edge] = (int)outputs.size();
+                    outputs.emplace_back();
+                    transitions.resize(transitions.size() + symbol_count, -1);
+                }
+                state = transitions[edge];
+            }
+            outputs[state].push_back(sequence.action);
+        }
+
+        // failure links turned straight into dfa edges, breadth first so a
+        // state's fallback is always finished before the state itself
+        int state_count = (int)outputs.size();
+        std::vector<int> fail(state_count, 0);
+        std::queue<int> pending;
+
+        for (int s = 0; s < symbol_count; s++) {
+            int& next = transitions[s];
+            if (next < 0) {
+                next = 0;
+            } else {
+                pending.push(next);
+            }
+        }
+
+        while (!pending.empty()) {
+            int state = pending.front();
+            pending.pop();
+
+            // matches of the longest proper suffix also end here
+            const std::vector<int>& inherited = outputs[fail[state]];
+            outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+
+            for (int s = 0; s < symbol_count; s++) {
+                int& next = transitions[state * symbol_count + s];
+                int fallback = transitions[fail[state] * symbol_count + s];
+                if (next < 0) {
+                    next = fallback;
+                } else {
+                    fail[next] = fallback;
+                    pending.push(next);
+                }
+            }
+        }
+
+        // flatten outputs, state i fires output_actions[output_begin[i] .. output_begin[i + 1])
+        output_begin.assign(state_count + 1, 0);
+        output_actions.clear();
+        for (int state = 0; state < state_count; state++) {
+            output_begin[state] = (int)output_actions.size();
+            output_actions.insert(output_actions.end(), outputs[state].begin(), outputs[state].end());
+        }
+        output_begin[state_count] = (int)output_actions.size();
+
+        current = 0;
+    }
+
+    // asks the os whether a modifier vk is down. a release the hook never
+    // sees (win+l, uac, ctrl+alt+del) would leave a modifier stuck, so while
+    // any is believed held the next press checks those against this
+    void set_modifier_probe(std::function<bool(int vk)> probe) {
+        modifier_probe = std::move(probe);
+    }
+
+    // first press of a key, held repeats should not be passed in.
+    // returns the actions it completed, valid until the next call
+    const std::vector<int>& key_down(int vk) {
+        fired.clear();
+
+        if (modifier_for_key(vk)) {
+            held[vk & 0xFF] = true;
+            update_modifiers();
+            return fired;
+        }
+
+        if (held_modifiers && modifier_probe) {
+            for (int modifier : MODIFIER_KEYS) {
+                if (held[modifier] && !modifier_probe(modifier)) held[modifier] = false;
+            }
+            update_modifiers();
+        }
+
+        int chord = chords[chord_index(held_modifiers, vk)];
+        if (chord != NO_ACTION) {
+            fired.push_back(chord);
+        }
+
+        if (!output_begin.empty()) {
+            current = transitions[current * symbol_count + symbols[vk & 0xFF]];
+            for (int i = output_begin[current]; i < output_begin[current + 1]; i++) {
+                fired.push_back(output_actions[i]);
+            }
+        }
+
+        return fired;
+    }
+
+    void key_up(int vk) {
+        if (modifier_for_key(vk)) {
+            held[vk & 0xFF] = false;
+            update_modifiers();
+        }
+    }
+
+    // CTRL | ALT | SHIFT | WIN of the modifiers currently held
+    int modifiers() const {
+        return held_modifiers;
+    }
+
+    size_t get_state_count() const {
+        return output_begin.empty() ? 0 : output_begin.size() - 1;
+    }
+
+private:
+    struct Sequence {
+        std::vector<int> keys;
+        int action;
+    };
+
+    static constexpr int MODIFIER_KEYS[] = {0x11, 0xA2, 0xA3, 0x12, 0xA4, 0xA5, 0x10, 0xA0, 0xA1, 0x5B, 0x5C};
+
+    static int chord_index(int modifiers, int vk) {
+        return ((modifiers & 0xF) << 8) | (vk & 0xFF);
+    }
+
+    // left and right are tracked apart so releasing one keeps the other held
+    void update_modifiers() {
+        held_modifiers = 0;
+        for (int vk : MODIFIER_KEYS) {
+            if (held[vk]) held_modifiers |= modifier_for_key(vk);
+        }
+    }
+
+    std::vector<int> chords = std::vector<int>(16 * 256, NO_ACTION);
+    std::vector<Sequence> sequences;
+
+    int symbols[256] = {};
+    int symbol_count = 1;
+    std::vector<int> transitions;       // state * symbol_count + symbol -> state
+    std::vector<int> output_begin;
+    std::vector<int> output_actions;
+    int current = 0;
+
+    bool held[256] = {};
+    int held_modifiers = 0;
+    std::function<bool(int vk)> modifier_probe;
+    std::vector<int> fired;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// single producer / single consumer, the writer never waits for the reader
+// and the reader always gets the most recent complete value
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+    
+    // writer side, fill this then publish()
+    T& write_buffer() {
+        return slots[back];
+    }
+    
+    void publish() {
+        back = state.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    
+    // reader side, returns true if read_buffer() now holds a newer value
+    bool acquire() {
+        if ((state.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+            return false;
+        }
+        front = state.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    
+    const T& read_buffer() const {
+        return slots[front];
+    }
+    
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+    
+    T slots[3];
+    std::atomic<uint8_t> state{1};
+    uint8_t back = 0;
+    uint8_t front = 2;
+};
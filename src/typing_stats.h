@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <algorithm>
+#include <functional>
+#include "definitions.h"
+
+// binary layout of the stats file, only ever grows at the end
+struct TypingStatsData {
+    static constexpr uint32_t MAGIC = 0x54534B46;   // "FKST"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int INTERVAL_BUCKETS = 16;     // [2^i, 2^(i+1)) ms, the last one is open ended
+    static constexpr int WPM_BUCKETS = 32;          // 10 wpm each, the last one is open ended
+
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sessions;
+    uint64_t presses;
+    uint64_t char_presses;
+    uint64_t active_ms;                             // time spent typing, idle gaps excluded
+    uint64_t key_counts[256];
+    uint64_t interval_counts[INTERVAL_BUCKETS];
+    uint64_t wpm_counts[WPM_BUCKETS];
+};
+
+// counters live directly in a memory mapped file and are bumped with relaxed
+// atomics, the os writes dirty pages back on its own so recording never
+// flushes. another process (--stats) can read the same file while it runs
+class TypingStats {
+public:
+    // a gap longer than this ends a typing burst
+    static constexpr uint32_t IDLE_MS = 2000;
+    // keys per wpm sample
+    static constexpr int WPM_WINDOW = 10;
+
+    TypingStats() = default;
+
+    TypingStats(const TypingStats&) = delete;
+    TypingStats& operator=(const TypingStats&) = delete;
+
+    ~TypingStats() {
+        close();
+    }
+
+    // creates the file when missing, falls back to memory only stats when it can't be mapped
+    bool open(const std::string& path, bool read_only = false) {
+        close();
+
+        DWORD access = read_only ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+        file = CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           read_only ? OPEN_EXISTING : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            file = nullptr;
+            use_memory(read_only);
+            return false;
+        }
+
+        DWORD high = 0;
+        DWORD size = GetFileSize(file, &high);
+        if (read_only && (high != 0 || size < sizeof(TypingStatsData))) {
+            close();
+            use_memory(read_only);
+            return false;
+        }
+
+        // mapping a writable file bigger than it is grows it
+        mapping = CreateFileMappingA(file, nullptr, read_only ? PAGE_READONLY : PAGE_READWRITE, 0, sizeof(TypingStatsData), nullptr);
+        if (mapping) {
+            data = (TypingStatsData*)MapViewOfFile(mapping, read_only ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, sizeof(TypingStatsData));
+        }
+        if (!data) {
+            close();
+            use_memory(read_only);
+            return false;
+        }
+
+        if (data->magic != TypingStatsData::MAGIC || data->version != TypingStatsData::VERSION) {
+            if (read_only) {
+                close();
+                use_memory(read_only);
+                return false;
+            }
+            std::memset(data, 0, sizeof(TypingStatsData));
+            data->magic = TypingStatsData::MAGIC;
+            data->version = TypingStatsData::VERSION;
+        }
+
+        if (!read_only) {
+            add(data->sessions, 1);
+        }
+        return true;
+    }
+
+    void close() {
+        if (data && data != &fallback) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file) CloseHandle(file);
+        data = nullptr;
+        mapping = file = nullptr;
+    }
+
+    bool is_persistent() const {
+        return data && data != &fallback;
+    }
+
+    // key event path, first press of a key only. time_ms is the event's tick
+    void record_press(int vk, uint32_t time_ms) {
+        if (!data) return;
+
+        add(data->presses, 1);
+        add(data->key_counts[vk & 0xFF], 1);
+
+        bool is_char = is_char_key(vk);
+        if (is_char) {
+            add(data->char_presses, 1);
+        }
+
+        if (has_last_press) {
+            uint32_t interval = time_ms - last_press_ms;
+            add(data->interval_counts[interval_bucket(interval)], 1);
+
+            if (interval < IDLE_MS) {
+                add(data->active_ms, interval);
+                window_ms += interval;
+                if (is_char && ++window_chars == WPM_WINDOW) {
+                    add(data->wpm_counts[wpm_bucket(window_ms)], 1);
+                    window_chars = 0;
+                    window_ms = 0;
+                }
+            } else {
+                window_chars = 0;
+                window_ms = 0;
+            }
+        }
+
+        last_press_ms = time_ms;
+        has_last_press = true;
+    }
+
+    uint64_t get_sessions() const {
+        return load(data->sessions);
+    }
+
+    uint64_t get_presses() const {
+        return load(data->presses);
+    }
+
+    uint64_t get_key_count(int vk) const {
+        return load(data->key_counts[vk & 0xFF]);
+    }
+
+    // five characters per word over the time actually spent typing
+    double get_average_wpm() const {
+        uint64_t ms = load(data->active_ms);
+        return ms == 0 ? 0.0 : load(data->char_presses) / 5.0 / (ms / 60000.0);
+    }
+
+    // upper edge of the bucket holding the p-th fraction of intervals
+    uint32_t interval_percentile_ms(double p) const {
+        int bucket = percentile_bucket(data->interval_counts, TypingStatsData::INTERVAL_BUCKETS, p);
+        return bucket < 0 ? 0 : 1u << (bucket + 1);
+    }
+
+    // lower edge of the bucket holding the p-th fraction of wpm samples
+    int wpm_percentile(double p) const {
+        int bucket = percentile_bucket(data->wpm_counts, TypingStatsData::WPM_BUCKETS, p);
+        return bucket < 0 ? 0 : bucket * 10;
+    }
+
+    // most pressed keys first
+    std::vector<std::pair<int, uint64_t>> top_keys(size_t count) const {
+        std::vector<std::pair<int, uint64_t>> keys;
+        for (int vk = 0; vk < 256; vk++) {
+            uint64_t presses = get_key_count(vk);
+            if (presses > 0) keys.push_back({vk, presses});
+        }
+        std::sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        if (keys.size() > count) keys.resize(count);
+        return keys;
+    }
+
+    void dump(std::ostream& out, const std::function<std::string(int)>& key_name) const {
+        out << "sessions: " << get_sessions() << "\n"
+            << "presses: " << get_presses() << "\n"
+            << "average wpm: " << (int)get_average_wpm() << "\n"
+            << "wpm p50/p90: " << wpm_percentile(0.5) << "/" << wpm_percentile(0.9) << "\n"
+            << "key interval p50/p90: <= " << interval_percentile_ms(0.5) << "/" << interval_percentile_ms(0.9) << " ms\n"
+            << "top keys:\n";
+        for (const auto& [vk, presses] : top_keys(10)) {
+            std::string name = key_name(vk);
+            out << "  " << (name.empty() ? "vk " + std::to_string(vk) : name) << ": " << presses << "\n";
+        }
+    }
+
+private:
+    static void add(uint64_t& counter, uint64_t value) {
+        std::atomic_ref<uint64_t>(counter).fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static uint64_t load(const uint64_t& counter) {
+        return std::atomic_ref<const uint64_t>(counter).load(std::memory_order_relaxed);
+    }
+
+    static bool is_char_key(int vk) {
+        // space, digits, letters, numpad digits and the oem punctuation keys
+        return vk == VK_SPACE || (vk >= 0x30 && vk <= 0x39) || (vk >= 0x41 && vk <= 0x5A) ||
+               (vk >= 0x60 && vk <= 0x69) || (vk >= 0xBA && vk <= 0xC0) || (vk >= 0xDB && vk <= 0xDF);
+    }
+
+    static int interval_bucket(uint32_t ms) {
+        int bucket = 0;
+        while (bucket < TypingStatsData::INTERVAL_BUCKETS - 1 && (ms >> (bucket + 1)) != 0) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    static int wpm_bucket(uint64_t window_ms) {
+        if (window_ms == 0) return TypingStatsData::WPM_BUCKETS - 1;
+        double wpm = WPM_WINDOW / 5.0 / (window_ms / 60000.0);
+        return std::min((int)(wpm / 10.0), TypingStatsData::WPM_BUCKETS - 1);
+    }
+
+    static int percentile_bucket(const uint64_t* counts, int buckets, double p) {
+        uint64_t total = 0;
+        for (int i = 0; i < buckets; i++) total += load(counts[i]);
+        if (total == 0) return -1;
+
+        uint64_t target = (uint64_t)(p * total);
+        uint64_t seen = 0;
+        for (int i = 0; i < buckets; i++) {
+            seen += load(counts[i]);
+            if (seen > target) return i;
+        }
+        return buckets - 1;
+    }
+
+    void use_memory(bool read_only) {
+        std::memset(&fallback, 0, sizeof(fallback));
+        fallback.magic = TypingStatsData::MAGIC;
+        fallback.version = TypingStatsData::VERSION;
+        fallback.sessions = read_only ? 0 : 1;
+        data = &fallback;
+    }
+
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+    TypingStatsData* data = nullptr;
+    TypingStatsData fallback = {};
+
+    // only touched from the key event path
+    uint32_t last_press_ms = 0;
+    bool has_last_press = false;
+    int window_chars = 0;
+    uint64_t window_ms = 0;
+};
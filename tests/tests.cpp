@@ -0,0 +1,536 @@
+// funny-keyboard-tests [name], headless checks of the parts that need no window
+// or audio device. not part of the default build, configure with
+// -DFUNNY_KEYBOARD_TESTS=ON and run through ctest or directly
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <raylib.h>
+#include "sample_cache.h"
+#include "placement.h"
+#include "control_server.h"
+#include "capture_encoder.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            failures++; \
+            std::cout << "  " << __FILE__ << ":" << __LINE__ << ": " << #condition << "\n"; \
+        } \
+    } while (0)
+
+// 16 bit mono pcm, seed makes the samples differ between files of one length
+static std::vector<unsigned char> make_wav(int frames, int seed)
+{
+    auto put = [](std::vector<unsigned char>& out, uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) out.push_back((unsigned char)(value >> (8 * i)));
+    };
+
+    std::vector<unsigned char> wav;
+    uint32_t data_bytes = (uint32_t)frames * 2;
+    wav.insert(wav.end(), {'R', 'I', 'F', 'F'});
+    put(wav, 36 + data_bytes, 4);
+    wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    put(wav, 16, 4);
+    put(wav, 1, 2);             // pcm
+    put(wav, 1, 2);             // mono
+    put(wav, 48000, 4);
+    put(wav, 48000 * 2, 4);
+    put(wav, 2, 2);
+    put(wav, 16, 2);
+    wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+    put(wav, data_bytes, 4);
+    for (int i = 0; i < frames; i++) {
+        put(wav, (uint32_t)((i * 37 + seed * 1009) & 0x7FFF), 2);
+    }
+    return wav;
+}
+
+// stands in for the device, every call is recorded
+struct FakeDevice {
+    int uploads = 0;
+    int aliases = 0;
+    int unloaded_aliases = 0;
+    int unloaded = 0;
+    bool alias_after_unload = false;
+    uintptr_t next_buffer = 1;
+
+    SampleBackend backend() {
+        SampleBackend b;
+        b.upload = [this](const Wave& wave) {
+            uploads++;
+            Sound sound = {};
+            sound.stream.buffer = (rAudioBuffer*)next_buffer++;
+            sound.stream.sampleRate = wave.sampleRate;
+            sound.stream.sampleSize = wave.sampleSize;
+            sound.stream.channels = wave.channels;
+            sound.frameCount = wave.frameCount;
+            return sound;
+        };
+        b.alias = [this](const Sound& source) {
+            aliases++;
+            return source;
+        };
+        b.unload_alias = [this](Sound&) {
+            unloaded_aliases++;
+            if (unloaded > 0) alias_after_unload = true;
+        };
+        b.unload = [this](Sound&) {
+            unloaded++;
+        };
+        return b;
+    }
+};
+
+static Sound load(SampleCache& cache, const std::vector<unsigned char>& wav)
+{
+    return cache.load_from_memory(".wav", wav.data(), (int)wav.size());
+}
+
+static void test_sample_cache()
+{
+    const int frames = 4800;
+    const size_t bytes = frames * 2;
+    std::vector<unsigned char> a = make_wav(frames, 1);
+    std::vector<unsigned char> b = make_wav(frames, 2);
+    std::vector<unsigned char> c = make_wav(frames / 2, 1);
+
+    FakeDevice device;
+    {
+        SampleCache cache(device.backend());
+
+        // same bytes share one upload, whatever key they were loaded for
+        CHECK(load(cache, a).frameCount == frames);
+        CHECK(load(cache, a).frameCount == frames);
+        CHECK(device.uploads == 1);
+        CHECK(device.aliases == 2);
+        CHECK(cache.get_stats().files == 2);
+        CHECK(cache.get_stats().unique == 1);
+        CHECK(cache.get_stats().stored_bytes == bytes);
+        CHECK(cache.get_stats().saved_bytes == bytes);
+
+        // different content is its own sample
+        CHECK(load(cache, b).frameCount == frames);
+        CHECK(load(cache, c).frameCount == frames / 2);
+        CHECK(device.uploads == 3);
+        CHECK(cache.get_stats().unique == 3);
+        CHECK(cache.get_stats().stored_bytes == bytes * 2 + bytes / 2);
+        CHECK(cache.get_stats().saved_bytes == bytes);
+
+        // not a wav, nothing is counted
+        std::vector<unsigned char> garbage(64, 0x5A);
+        CHECK(load(cache, garbage).frameCount == 0);
+        CHECK(cache.get_stats().files == 4);
+        CHECK(device.uploads == 3);
+
+        // aliases go before the sources they point at
+        cache.clear();
+        CHECK(device.unloaded_aliases == 4);
+        CHECK(device.unloaded == 3);
+        CHECK(!device.alias_after_unload);
+        CHECK(cache.get_stats().files == 0);
+        CHECK(cache.get_stats().stored_bytes == 0);
+    }
+
+    // every file lands in one bucket, only size and the second hash tell them apart
+    FakeDevice colliding;
+    {
+        SampleCache cache(colliding.backend(), [](const unsigned char*, size_t) { return (uint64_t)42; });
+        CHECK(load(cache, a).frameCount == frames);
+        CHECK(load(cache, b).frameCount == frames);     // same size, same bucket
+        CHECK(load(cache, c).frameCount == frames / 2); // same bucket, other size
+        CHECK(load(cache, b).frameCount == frames);
+        CHECK(colliding.uploads == 3);
+        CHECK(cache.get_stats().unique == 3);
+        CHECK(cache.get_stats().saved_bytes == bytes);
+    }
+    CHECK(colliding.unloaded == 3);
+    CHECK(colliding.unloaded_aliases == 4);
+}
+
+// a 4x3 grid of 100 px cells at the origin, effects live one second
+static EffectPlacer make_placer(int max_overdraw, PlacementBias bias = PlacementBias::NONE)
+{
+    PlacementConfig config;
+    config.cell_size = 100.0f;
+    config.max_overdraw = max_overdraw;
+    config.bias = bias;
+    config.region[0] = 0.0f;
+    config.region[1] = 0.0f;
+    config.region[2] = 0.25f;
+    config.region[3] = 1.0f / 3.0f;
+
+    EffectPlacer placer;
+    placer.configure(config, 1.0f);
+    placer.add_region(0.0f, 0.0f, 400.0f, 300.0f, 1.0f);
+    return placer;
+}
+
+static int cell_at(float x, float y)
+{
+    return (int)(y / 100.0f) * 4 + (int)(x / 100.0f);
+}
+
+static void test_placement()
+{
+    const int cells = 12;
+    float x, y;
+    uint32_t ticket;
+
+    // free cells are used up one by one before anything stacks
+    {
+        EffectPlacer placer = make_placer(2);
+        std::vector<int> used(cells, 0);
+        for (int i = 0; i < cells; i++) {
+            CHECK(placer.place(0, 0.0, nullptr, x, y, ticket));
+            used[cell_at(x, y)]++;
+            CHECK(placer.get_free_count(0) == (size_t)(cells - 1 - i));
+        }
+        CHECK(std::count(used.begin(), used.end(), 1) == cells);
+        CHECK(placer.get_overdraw().max == 1);
+        CHECK(placer.get_overdraw().average == 1.0);
+
+        // then every cell takes a second effect and the next one is turned away
+        for (int i = 0; i < cells; i++) {
+            CHECK(placer.place(0, 0.0, nullptr, x, y, ticket));
+        }
+        CHECK(placer.get_overdraw().max == 2);
+        CHECK(!placer.place(0, 0.0, nullptr, x, y, ticket));
+        CHECK(placer.get_overdraw().rejected == 1);
+        CHECK(placer.get_overdraw().placed == (uint64_t)cells * 2);
+    }
+
+    // a released cell goes back on the free list and is the next one taken
+    {
+        EffectPlacer placer = make_placer(1);
+        std::vector<uint32_t> tickets(cells);
+        std::vector<int> cell_of(cells);
+        for (int i = 0; i < cells; i++) {
+            placer.place(0, 0.0, nullptr, x, y, tickets[i]);
+            cell_of[i] = cell_at(x, y);
+        }
+        CHECK(placer.get_free_count(0) == 0);
+        CHECK(!placer.place(0, 0.0, nullptr, x, y, ticket));
+
+        placer.release(tickets[5]);
+        CHECK(placer.get_free_count(0) == 1);
+        placer.release(tickets[5]);             // a second release is a no-op
+        CHECK(placer.get_free_count(0) == 1);
+        CHECK(placer.place(0, 0.1, nullptr, x, y, ticket));
+        CHECK(cell_at(x, y) == cell_of[5]);
+        CHECK(placer.get_free_count(0) == 0);
+
+        // expiry gives back everything but the cell whose ticket was released and retaken
+        CHECK(!placer.place(0, 0.99, nullptr, x, y, ticket));
+        CHECK(placer.place(0, 1.0, nullptr, x, y, ticket));
+        CHECK(placer.get_free_count(0) == (size_t)cells - 2);
+    }
+
+    // renew keeps the cell for another lifetime under a new ticket
+    {
+        EffectPlacer placer = make_placer(1);
+        uint32_t first;
+        placer.place(0, 0.0, nullptr, x, y, first);
+
+        uint32_t renewed = placer.renew(first, 0.5);
+        CHECK(renewed != first);
+        CHECK(placer.get_live_count() == 2);
+        CHECK(placer.get_free_count(0) == (size_t)cells - 1);
+        CHECK(placer.renew(first, 0.6) == first);   // the old ticket is spent
+
+        // the old entry retires at 1.0 without giving the cell back, the renewed one at 1.5 does
+        CHECK(placer.renew(first, 1.2) == first);
+        CHECK(placer.get_live_count() == 1);
+        CHECK(placer.get_free_count(0) == (size_t)cells - 1);
+        placer.renew(first, 1.5);
+        CHECK(placer.get_live_count() == 0);
+        CHECK(placer.get_free_count(0) == (size_t)cells);
+    }
+
+    // a released ticket doesn't free the cell a second time when it expires
+    {
+        EffectPlacer placer = make_placer(2);
+        uint32_t a, b;
+        placer.place(0, 0.0, nullptr, x, y, a);
+        placer.release(a);
+        CHECK(placer.get_free_count(0) == (size_t)cells);
+        placer.place(0, 0.5, nullptr, x, y, b);
+        CHECK(placer.get_free_count(0) == (size_t)cells - 1);
+        placer.renew(b, 1.0);                   // retires a, which must leave b's cell alone
+        CHECK(placer.get_free_count(0) == (size_t)cells - 1);
+        CHECK(placer.get_live_count() == 2);
+    }
+
+    // bias pulls towards the target cell, the top left one here
+    {
+        float caret[2] = {50.0f, 50.0f};
+        EffectPlacer caret_placer = make_placer(1, PlacementBias::CARET);
+        EffectPlacer region_placer = make_placer(1, PlacementBias::REGION);
+        EffectPlacer plain_placer = make_placer(1);
+        int caret_hits = 0, region_hits = 0, plain_hits = 0;
+        const int rounds = 400;
+
+        for (int i = 0; i < rounds; i++) {
+            caret_placer.place(0, 0.0, caret, x, y, ticket);
+            caret_hits += cell_at(x, y) == 0;
+            caret_placer.release(ticket);
+
+            region_placer.place(0, 0.0, nullptr, x, y, ticket);
+            region_hits += cell_at(x, y) == 0;
+            region_placer.release(ticket);
+
+            plain_placer.place(0, 0.0, caret, x, y, ticket);    // no bias, the point is ignored
+            plain_hits += cell_at(x, y) == 0;
+            plain_placer.release(ticket);
+        }
+
+        // six samples out of twelve cells find the target about 40% of the time, one about 8%
+        CHECK(caret_hits > rounds / 4);
+        CHECK(region_hits > rounds / 4);
+        CHECK(plain_hits < rounds / 6);
+    }
+}
+
+// a raw client end of the pipe, for what ControlServer::request can't do. the
+// one instance stays busy until the server lets the last client go
+static HANDLE open_pipe(const std::string& name)
+{
+    std::string path = ControlServer::pipe_path(name);
+    HANDLE client = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (client == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipeA(path.c_str(), 2000)) {
+        client = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    }
+    return client;
+}
+
+static std::string read_lines(HANDLE client, int lines)
+{
+    std::string text;
+    char buffer[256];
+    while (std::count(text.begin(), text.end(), '\n') < lines) {
+        DWORD read = 0;
+        if (!ReadFile(client, buffer, sizeof(buffer), &read, nullptr) || read == 0) break;
+        text.append(buffer, read);
+    }
+    return text;
+}
+
+static double milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the overlay's endpoint and the --control client round trip over a real pipe
+static void test_control()
+{
+    const std::string name = "funny-keyboard-tests-" + std::to_string(GetTickCount());
+    std::atomic<int> handled{0};
+    auto echo = [&](const std::string& request) {
+        handled++;
+        return "re " + request;
+    };
+
+    ControlServer server;
+    CHECK(server.start(name, echo));
+    CHECK(server.is_running());
+
+    // one pipe name, one overlay
+    ControlServer second;
+    CHECK(!second.start(name, echo));
+
+    // a client per request, the server takes the next one after each hangs up
+    std::string reply;
+    for (const char* request : {"stats", "volume 0.5", "colorize {\"mode\":\"hue\"}", "reset"}) {
+        CHECK(ControlServer::request(name, request, reply));
+        CHECK(reply == std::string("re ") + request);
+    }
+    CHECK(server.get_request_count() == 4);
+
+    // several requests in one write, crlf and blank lines, one reply per request
+    HANDLE client = open_pipe(name);
+    CHECK(client != INVALID_HANDLE_VALUE);
+    if (client != INVALID_HANDLE_VALUE) {
+        const char batch[] = "a\r\n\nb\nc";
+        DWORD written = 0;
+        CHECK(WriteFile(client, batch, sizeof(batch) - 1, &written, nullptr));
+        CHECK(read_lines(client, 2) == "re a\nre b\n");
+        CHECK(WriteFile(client, "\n", 1, &written, nullptr));
+        CHECK(read_lines(client, 1) == "re c\n");
+        CloseHandle(client);
+    }
+    CHECK(server.get_request_count() == 7);
+
+    // a client that connects and goes quiet can't hold up shutting down
+    client = open_pipe(name);
+    CHECK(client != INVALID_HANDLE_VALUE);
+    auto start = std::chrono::steady_clock::now();
+    server.stop();
+    double stop_ms = milliseconds_since(start);
+    CHECK(stop_ms < 1000.0);
+    CHECK(!server.is_running());
+    if (client != INVALID_HANDLE_VALUE) {
+        // the server end went away under it
+        char buffer[16];
+        DWORD read = 0;
+        CHECK(!ReadFile(client, buffer, sizeof(buffer), &read, nullptr) || read == 0);
+        CloseHandle(client);
+    }
+
+    // nobody listening
+    CHECK(!ControlServer::request(name, "stats", reply));
+
+    // the name is free again, and stopping an idle server is as quick
+    CHECK(server.start(name, echo));
+    CHECK(ControlServer::request(name, "again", reply));
+    CHECK(reply == "re again");
+    start = std::chrono::steady_clock::now();
+    server.stop();
+    CHECK(milliseconds_since(start) < 1000.0);
+    CHECK(handled == 8);
+}
+
+// a readback of the rectangle at x, y with alpha from the top left down, the
+// rows stored bottom up like gl returns them
+static void fill_frame(CaptureFrame* frame, int x, int y, int width, int height, std::vector<unsigned char> alpha, int repeats_before)
+{
+    frame->x = x;
+    frame->y = y;
+    frame->width = width;
+    frame->height = height;
+    frame->repeats_before = repeats_before;
+    frame->pixels.assign((size_t)width * height * 4, 0);
+    for (int row = 0; row < height; row++) {
+        for (int column = 0; column < width; column++) {
+            unsigned char* pixel = &frame->pixels[((size_t)(height - 1 - row) * width + column) * 4];
+            pixel[0] = pixel[1] = pixel[2] = 255;
+            pixel[3] = alpha[(size_t)row * width + column];
+        }
+    }
+}
+
+// the alpha plane of every frame in a C444alpha y4m, empty if the header is off
+static std::vector<std::vector<unsigned char>> read_y4m_alpha(const std::string& path, int width, int height)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<std::vector<unsigned char>> frames;
+    std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) + " F30:1 Ip A1:1 C444alpha\n";
+    if (data.compare(0, header.size(), header) != 0) return frames;
+
+    size_t plane = (size_t)width * height;
+    size_t at = header.size();
+    while (data.compare(at, 6, "FRAME\n") == 0 && at + 6 + plane * 4 <= data.size()) {
+        const char* alpha = &data[at + 6 + plane * 3];
+        frames.emplace_back(alpha, alpha + plane);
+        at += 6 + plane * 4;
+    }
+    return frames;
+}
+
+// the capture's encoder side, rows back the right way up, damage patched into
+// the kept frame and dropped frames written as repeats
+static void test_capture_encoder()
+{
+    const std::string path = "funny-keyboard-tests-capture";
+    const int width = 4, height = 3;
+
+    CaptureEncoder encoder;
+    CHECK(encoder.start(path, CaptureFormat::Y4M, width, height, 30, 2));
+
+    // a full frame, alpha counts up from the top left
+    std::vector<unsigned char> full(width * height);
+    for (size_t i = 0; i < full.size(); i++) full[i] = (unsigned char)(i + 1);
+    CaptureFrame* frame = encoder.acquire(true);
+    CHECK(frame != nullptr);
+    if (frame) {
+        fill_frame(frame, 0, 0, width, height, full, 0);
+        encoder.submit(frame);
+    }
+
+    // the pool is the queue, a full queue drops instead of growing
+    CaptureFrame* damaged = encoder.acquire(true);
+    CaptureFrame* repeat = encoder.acquire(true);
+    CHECK(damaged != nullptr && repeat != nullptr);
+    CHECK(encoder.acquire() == nullptr);
+    if (damaged && repeat) {
+        // two frames went missing before this one, then nothing changed
+        fill_frame(damaged, 1, 2, 2, 1, {100, 101}, 2);
+        encoder.submit(damaged);
+        repeat->width = repeat->height = 0;
+        encoder.submit(repeat);
+    }
+
+    // waits for the encoder to hand a frame back
+    frame = encoder.acquire(true);
+    CHECK(frame != nullptr);
+    if (frame) {
+        fill_frame(frame, 0, 0, 1, 1, {200}, 0);
+        encoder.submit(frame);
+    }
+    encoder.stop();
+    CHECK(encoder.get_written() == 6);
+
+    std::vector<unsigned char> patched = full;
+    patched[2 * width + 1] = 100;
+    patched[2 * width + 2] = 101;
+    std::vector<unsigned char> last = patched;
+    last[0] = 200;
+
+    auto frames = read_y4m_alpha(encoder.get_output_path(), width, height);
+    CHECK(frames.size() == 6);
+    if (frames.size() == 6) {
+        CHECK(frames[0] == full);
+        CHECK(frames[1] == full);
+        CHECK(frames[2] == full);
+        CHECK(frames[3] == patched);
+        CHECK(frames[4] == patched);
+        CHECK(frames[5] == last);
+    }
+    std::remove(encoder.get_output_path().c_str());
+}
+
+struct Test {
+    const char* name;
+    void (*run)();
+};
+
+static const Test TESTS[] = {
+    {"sample_cache", test_sample_cache},
+    {"placement", test_placement},
+    {"control", test_control},
+    {"capture_encoder", test_capture_encoder},
+};
+
+int main(int argc, char** argv)
+{
+    SetTraceLogLevel(LOG_WARNING);
+
+    int ran = 0;
+    for (const Test& test : TESTS) {
+        if (argc > 1 && std::strcmp(argv[1], test.name) != 0) continue;
+
+        int before = failures;
+        test.run();
+        std::cout << test.name << ": " << (failures == before ? "ok" : "FAILED") << "\n";
+        ran++;
+    }
+
+    if (ran == 0) {
+        std::cout << "usage: funny-keyboard-tests [test]\n";
+        for (const Test& test : TESTS) {
+            std::cout << "  " << test.name << "\n";
+        }
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}